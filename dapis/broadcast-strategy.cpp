@@ -27,6 +27,8 @@
 #include "algorithm.hpp"
 #include "core/logger.hpp"
 
+#include <ndn-cxx/lp/tags.hpp>
+
 namespace nfd {
 namespace fw {
 
@@ -34,9 +36,90 @@ const Name BroadcastStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/broadca
 NFD_LOG_INIT("BroadcastStrategy");
 NFD_REGISTER_STRATEGY(BroadcastStrategy);
 
+// neighbors of every forwarder, identified by its face table. The table is owned by
+// the strategy instances of the forwarder, so that it goes with them and a forwarder
+// later allocated at the same address starts with no neighbors
+static shared_ptr<BroadcastStrategy::NeighborTable>
+getNeighborTable(const FaceTable& faceTable)
+{
+  static std::unordered_map<const FaceTable*, weak_ptr<BroadcastStrategy::NeighborTable>> tables;
+  for (auto it = tables.begin(); it != tables.end(); ) {
+    if (it->second.expired()) {
+      it = tables.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  weak_ptr<BroadcastStrategy::NeighborTable>& table = tables[&faceTable];
+  shared_ptr<BroadcastStrategy::NeighborTable> neighbors = table.lock();
+  if (neighbors == nullptr) {
+    neighbors = make_shared<BroadcastStrategy::NeighborTable>();
+    table = neighbors;
+  }
+  return neighbors;
+}
+
 BroadcastStrategy::BroadcastStrategy(Forwarder& forwarder, const Name& name)
-    :Strategy(forwarder, name)
+  : Strategy(forwarder, name)
+  , m_target(0)
+  , m_minProbability(10)
+  , m_neighborTimeout(5000)
+  , m_random(ns3::CreateObject<ns3::UniformRandomVariable>())
+  , m_neighbors(getNeighborTable(getFaceTable()))
 {
+  for (const char* type : {"beacon", "bitmap", "movie1", "movie2"}) {
+    m_classes[name::Component(type)] = PacketClass{50, 0};
+  }
+
+  uint64_t beaconHopLimit = 0;
+  uint64_t bitmapHopLimit = 0;
+  uint64_t pieceHopLimit = 0;
+
+  for (const auto& parameter : parseParameters(parseInstanceName(name).parameters)) {
+    const std::string& key = parameter.first;
+    unsigned long value = parameter.second;
+    if (key == "target") {
+      m_target = value;
+    }
+    else if (key == "min") {
+      m_minProbability = std::min<unsigned long>(value, 100);
+    }
+    else if (key == "timeout") {
+      m_neighborTimeout = time::milliseconds(value);
+    }
+    else if (key == "beacon-hops") {
+      beaconHopLimit = value;
+    }
+    else if (key == "bitmap-hops") {
+      bitmapHopLimit = value;
+    }
+    else if (key == "piece-hops") {
+      pieceHopLimit = value;
+    }
+    else if (key.compare(0, 6, "class-") == 0 && key.size() > 6) {
+      unsigned int probability = std::min<unsigned long>(value, 100);
+      m_classes[name::Component(key.substr(6))] = PacketClass{probability, 0};
+    }
+    else {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("BroadcastStrategy does not accept parameter " + key));
+    }
+  }
+
+  for (auto& packetClass : m_classes) {
+    if (packetClass.first == name::Component("beacon")) {
+      packetClass.second.hopLimit = beaconHopLimit;
+    }
+    else if (packetClass.first == name::Component("bitmap")) {
+      packetClass.second.hopLimit = bitmapHopLimit;
+    }
+    else {
+      packetClass.second.hopLimit = pieceHopLimit;
+    }
+  }
+
+  this->setInstanceName(makeInstanceName(name, getStrategyName()));
 }
 
 const Name&
@@ -45,21 +128,58 @@ BroadcastStrategy::getStrategyName()
   return STRATEGY_NAME;
 }
 
+size_t
+BroadcastStrategy::ComponentHash::operator()(const name::Component& component) const
+{
+  // FNV-1a over the value of the component
+  size_t hash = 2166136261u;
+  for (size_t i = 0; i < component.value_size(); ++i) {
+    hash = (hash ^ component.value()[i]) * 16777619u;
+  }
+  return hash;
+}
+
 void
 BroadcastStrategy::afterReceiveInterest(const Face& inFace, const Interest& interest,
                                         const shared_ptr<pit::Entry>& pitEntry)
 {
-  std::string interestType = interest.getName().get(0).toUri();
+  const Name& interestName = interest.getName();
+  auto packetClass = interestName.empty() ? m_classes.end() : m_classes.find(interestName.get(0));
+
+  observeNeighbor(inFace, interest);
 
-  const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
-  const fib::NextHopList& nexthops = fibEntry.getNextHops();
+  if (packetClass != m_classes.end()) {
+    unsigned int forwardProbability = getForwardProbability(packetClass->second);
 
-  for (fib::NextHopList::const_iterator it = nexthops.begin(); it != nexthops.end(); ++it) {
-    // Choose Probabilty to forward (/beacon, /bitmap, /movie1)
-    unsigned int forwarding = rand() % 100 + 1;
-    Face& outFace = it->getFace();
-    if (interestType == "beacon" || interestType == "bitmap" || interestType == "movie1" || interestType == "movie2") {
-      if (!wouldViolateScope(inFace, interest, outFace) && forwarding > 50) {
+    // number of hops travelled, counted by the link service on reception
+    uint64_t hopLimit = packetClass->second.hopLimit;
+    shared_ptr<lp::HopCountTag> hopCountTag = interest.getTag<lp::HopCountTag>();
+    bool isHopLimitReached = hopLimit != 0 && hopCountTag != nullptr && *hopCountTag >= hopLimit;
+
+    const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
+    const fib::NextHopList& nexthops = fibEntry.getNextHops();
+
+    for (fib::NextHopList::const_iterator it = nexthops.begin(); it != nexthops.end(); ++it) {
+      Face& outFace = it->getFace();
+      if (wouldViolateScope(inFace, interest, outFace)) {
+        continue;
+      }
+      bool isLocal = outFace.getScope() == ndn::nfd::FACE_SCOPE_LOCAL;
+      // in gossip mode, local applications (but the sender) always get the
+      // Interest, only the rebroadcasts to other nodes are limited
+      if (isLocal && m_target != 0) {
+        if (&outFace != &inFace) {
+          this->sendInterest(pitEntry, outFace, interest);
+        }
+        continue;
+      }
+      if (isHopLimitReached && !isLocal) {
+        NFD_LOG_DEBUG("Interest reached its hop limit of " << hopLimit);
+        continue;
+      }
+      // Choose Probabilty to forward
+      unsigned int forwarding = m_random->GetInteger(1, 100);
+      if (forwarding > 100 - forwardProbability) {
         NFD_LOG_DEBUG("Forwarding Interest!! Probability Chosen: " << forwarding);
         this->sendInterest(pitEntry, outFace, interest);
       }
@@ -72,5 +192,72 @@ BroadcastStrategy::afterReceiveInterest(const Face& inFace, const Interest& inte
   }
 }
 
+// node id of a node<id> name component, or -1
+static int64_t
+getNodeId(const name::Component& component)
+{
+  std::string value(reinterpret_cast<const char*>(component.value()), component.value_size());
+  if (value.size() <= 4 || value.size() > 13 || value.compare(0, 4, "node") != 0 ||
+      value.find_first_not_of("0123456789", 4) != std::string::npos) {
+    return -1;
+  }
+  return std::stoll(value.substr(4));
+}
+
+void
+BroadcastStrategy::observeNeighbor(const Face& inFace, const Interest& interest)
+{
+  // Interests of the local applications do not come from a neighbor
+  if (m_target == 0 || inFace.getScope() == ndn::nfd::FACE_SCOPE_LOCAL) {
+    return;
+  }
+
+  // an Interest relayed on the way comes from a node that is not a neighbor
+  shared_ptr<lp::HopCountTag> hopCountTag = interest.getTag<lp::HopCountTag>();
+  if (hopCountTag != nullptr && *hopCountTag > 1) {
+    return;
+  }
+
+  // only beacons and bitmap Interests name their originator, as their first
+  // node<id> component
+  const Name& name = interest.getName();
+  if (name.empty() || (name.get(0) != name::Component("beacon") &&
+                       name.get(0) != name::Component("bitmap"))) {
+    return;
+  }
+
+  for (const auto& component : name) {
+    int64_t nodeId = getNodeId(component);
+    if (nodeId >= 0) {
+      (*m_neighbors)[static_cast<uint32_t>(nodeId)] = time::steady_clock::now();
+      return;
+    }
+  }
+}
+
+unsigned int
+BroadcastStrategy::getForwardProbability(const PacketClass& packetClass)
+{
+  if (m_target == 0) {
+    return packetClass.probability;
+  }
+
+  time::steady_clock::TimePoint now = time::steady_clock::now();
+  for (auto it = m_neighbors->begin(); it != m_neighbors->end(); ) {
+    if (now - it->second > m_neighborTimeout) {
+      it = m_neighbors->erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  // with no more neighbors than the target, every one of them has to forward
+  if (m_neighbors->size() <= m_target) {
+    return 100;
+  }
+  return std::max<unsigned int>(m_minProbability, 100 * m_target / m_neighbors->size());
+}
+
 } // namespace fw
 } // namespace nfd
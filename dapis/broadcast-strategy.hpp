@@ -28,10 +28,32 @@
 
 #include "strategy.hpp"
 
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+
 namespace nfd {
 namespace fw {
 
 /** \brief a forwarding strategy that forwards Interest to all FIB nexthops
+ *
+ *  Interests are classified by their first name component: beacon, bitmap and the
+ *  torrents movie1 and movie2 by default, more torrents being added with the parameter
+ *  class-<component>~<percent>. Interests of other classes are not forwarded.
+ *  Every nexthop is used with the probability of the class (50% by default), or in
+ *  gossip mode, where local application faces always get the Interest, every nexthop
+ *  to another node is used with probability
+ *  target / number of neighbors (but at least min percent), the neighbors being the
+ *  node<id> originators of the beacons and bitmaps heard directly (one hop) during the
+ *  last timeout milliseconds. As only beacons and bitmaps name their originator, all
+ *  the instances of a forwarder share the neighbors.
+ *  Gossip mode is enabled with the parameters of the strategy instance name:
+ *  /localhost/nfd/strategy/broadcast/%FD%01/target~3/min~10/timeout~5000
+ *
+ *  The parameters beacon-hops~N, bitmap-hops~N and piece-hops~N (for the torrent
+ *  classes) stop forwarding the Interests of a class to other nodes once they have
+ *  travelled N hops.
  */
 class BroadcastStrategy : public Strategy
 {
@@ -45,8 +67,51 @@ public:
   afterReceiveInterest(const Face& inFace, const Interest& interest,
                        const shared_ptr<pit::Entry>& pitEntry) override;
 
+private:
+  /** \brief forwarding parameters of a class of Interests
+   */
+  struct PacketClass
+  {
+    unsigned int probability; ///< percent
+    uint64_t hopLimit; ///< 0 for no limit
+  };
+
+  struct ComponentHash
+  {
+    size_t
+    operator()(const name::Component& component) const;
+  };
+
+  /** \brief record the originator of a beacon or bitmap Interest heard
+   *         directly from another node
+   */
+  void
+  observeNeighbor(const Face& inFace, const Interest& interest);
+
+  /** \brief probability in percent to forward an Interest of a class to a nexthop
+   */
+  unsigned int
+  getForwardProbability(const PacketClass& packetClass);
+
 public:
   static const Name STRATEGY_NAME;
+
+  // <node id, time last heard>
+  typedef std::unordered_map<uint32_t, time::steady_clock::TimePoint> NeighborTable;
+
+private:
+  // number of neighbors that should forward an Interest, 0 for the fixed probability
+  unsigned int m_target;
+  unsigned int m_minProbability;
+  time::milliseconds m_neighborTimeout;
+
+  // classes by first name component, built once at construction
+  std::unordered_map<name::Component, PacketClass, ComponentHash> m_classes;
+
+  ns3::Ptr<ns3::UniformRandomVariable> m_random;
+
+  // shared by the instances of the forwarder
+  shared_ptr<NeighborTable> m_neighbors;
 };
 
 } // namespace fw
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "counter-broadcast-strategy.hpp"
+#include "algorithm.hpp"
+#include "core/logger.hpp"
+
+namespace nfd {
+namespace fw {
+
+const Name CounterBroadcastStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/counter-broadcast/%FD%01");
+NFD_LOG_INIT("CounterBroadcastStrategy");
+NFD_REGISTER_STRATEGY(CounterBroadcastStrategy);
+
+CounterBroadcastStrategy::CounterBroadcastStrategy(Forwarder& forwarder, const Name& name)
+  : Strategy(forwarder, name)
+  , m_maxDelay(20)
+  , m_threshold(3)
+  , m_random(ns3::CreateObject<ns3::UniformRandomVariable>())
+{
+  for (const auto& parameter : parseParameters(parseInstanceName(name).parameters)) {
+    const std::string& key = parameter.first;
+    unsigned long value = parameter.second;
+    if (key == "delay") {
+      m_maxDelay = time::milliseconds(value);
+    }
+    else if (key == "threshold") {
+      m_threshold = std::max<unsigned long>(value, 1);
+    }
+    else {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("CounterBroadcastStrategy does not accept parameter " + key));
+    }
+  }
+  this->setInstanceName(makeInstanceName(name, getStrategyName()));
+}
+
+CounterBroadcastStrategy::~CounterBroadcastStrategy()
+{
+  for (auto& pending : m_pending) {
+    scheduler::cancel(pending.second.event);
+  }
+}
+
+const Name&
+CounterBroadcastStrategy::getStrategyName()
+{
+  return STRATEGY_NAME;
+}
+
+void
+CounterBroadcastStrategy::afterReceiveInterest(const Face& inFace, const Interest& interest,
+                                               const shared_ptr<pit::Entry>& pitEntry)
+{
+  bool isFromNeighbor = inFace.getScope() == ndn::nfd::FACE_SCOPE_NON_LOCAL;
+
+  const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
+  const fib::NextHopList& nexthops = fibEntry.getNextHops();
+
+  bool hasRemoteNexthop = false;
+  for (const fib::NextHop& nexthop : nexthops) {
+    Face& outFace = nexthop.getFace();
+    if (wouldViolateScope(inFace, interest, outFace)) {
+      continue;
+    }
+    if (isFromNeighbor && outFace.getScope() == ndn::nfd::FACE_SCOPE_NON_LOCAL) {
+      hasRemoteNexthop = true;
+      continue;
+    }
+    this->sendInterest(pitEntry, outFace, interest);
+  }
+
+  // listen before rebroadcasting to the other nodes
+  RebroadcastKey key(interest.getName(), interest.getNonce());
+  if (hasRemoteNexthop && m_pending.count(key) == 0) {
+    time::milliseconds delay(static_cast<time::milliseconds::rep>(m_random->GetValue(0, m_maxDelay.count())));
+    NFD_LOG_DEBUG("Deferring rebroadcast of " << interest.getName() << " by " << delay);
+    PendingRebroadcast& pending = m_pending[key];
+    pending.pitEntry = pitEntry;
+    pending.inFaceId = inFace.getId();
+    pending.count = 1;
+    pending.event = scheduler::schedule(delay, bind(&CounterBroadcastStrategy::rebroadcast, this, key));
+    return;
+  }
+
+  if (!hasPendingOutRecords(*pitEntry)) {
+    this->rejectPendingInterest(pitEntry);
+  }
+}
+
+void
+CounterBroadcastStrategy::afterReceiveLoopedInterest(const Face& inFace, const Interest& interest)
+{
+  auto pending = m_pending.find(RebroadcastKey(interest.getName(), interest.getNonce()));
+  if (pending == m_pending.end() || inFace.getScope() != ndn::nfd::FACE_SCOPE_NON_LOCAL) {
+    return;
+  }
+
+  pending->second.count++;
+  if (pending->second.count >= m_threshold) {
+    NFD_LOG_DEBUG("Cancelling rebroadcast of " << interest.getName() << ", heard " <<
+                  pending->second.count << " times");
+    scheduler::cancel(pending->second.event);
+    shared_ptr<pit::Entry> pitEntry = pending->second.pitEntry.lock();
+    m_pending.erase(pending);
+
+    if (pitEntry != nullptr && !hasPendingOutRecords(*pitEntry)) {
+      this->rejectPendingInterest(pitEntry);
+    }
+  }
+}
+
+void
+CounterBroadcastStrategy::rebroadcast(const RebroadcastKey& key)
+{
+  auto pending = m_pending.find(key);
+  if (pending == m_pending.end()) {
+    return;
+  }
+  shared_ptr<pit::Entry> pitEntry = pending->second.pitEntry.lock();
+  Face* inFace = this->getFace(pending->second.inFaceId);
+  m_pending.erase(pending);
+
+  if (pitEntry == nullptr || inFace == nullptr) {
+    return;
+  }
+
+  // the in-record of the neighbor holds the Interest with the Nonce to keep
+  auto inRecord = pitEntry->getInRecord(*inFace);
+  if (inRecord == pitEntry->in_end()) {
+    return;
+  }
+  const Interest& interest = inRecord->getInterest();
+
+  const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
+  for (const fib::NextHop& nexthop : fibEntry.getNextHops()) {
+    Face& outFace = nexthop.getFace();
+    if (outFace.getScope() == ndn::nfd::FACE_SCOPE_NON_LOCAL &&
+        !wouldViolateScope(*inFace, interest, outFace)) {
+      NFD_LOG_DEBUG("Rebroadcasting " << interest.getName());
+      this->sendInterest(pitEntry, outFace, interest);
+    }
+  }
+
+  if (!hasPendingOutRecords(*pitEntry)) {
+    this->rejectPendingInterest(pitEntry);
+  }
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_COUNTER_BROADCAST_STRATEGY_HPP
+#define NFD_DAEMON_FW_COUNTER_BROADCAST_STRATEGY_HPP
+
+#include "strategy.hpp"
+#include "core/scheduler.hpp"
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <map>
+
+namespace nfd {
+namespace fw {
+
+/** \brief a broadcast strategy that listens before rebroadcasting (counter-based broadcast)
+ *
+ *  Interests from local applications are forwarded to all FIB nexthops right away.
+ *  An Interest heard from another node is delivered to the local nexthops right away,
+ *  while its rebroadcast to the other nodes is deferred by a random delay. Every copy
+ *  of the Interest (same name and Nonce) overheard during the wait is counted, and the
+ *  rebroadcast is cancelled once the Interest has been heard threshold times in total.
+ *
+ *  The parameters of the strategy instance name set the longest delay in milliseconds
+ *  and the threshold:
+ *  /localhost/nfd/strategy/counter-broadcast/%FD%01/delay~20/threshold~3
+ */
+class CounterBroadcastStrategy : public Strategy
+{
+public:
+  CounterBroadcastStrategy(Forwarder& forwarder, const Name& name = STRATEGY_NAME);
+
+  ~CounterBroadcastStrategy();
+
+  static const Name&
+  getStrategyName();
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       const shared_ptr<pit::Entry>& pitEntry) override;
+
+  virtual void
+  afterReceiveLoopedInterest(const Face& inFace, const Interest& interest) override;
+
+private:
+  typedef std::pair<Name, uint32_t> RebroadcastKey;
+
+  /** \brief rebroadcast an Interest to the other nodes, unless it has been overheard
+   *         too many times since its reception
+   */
+  void
+  rebroadcast(const RebroadcastKey& key);
+
+public:
+  static const Name STRATEGY_NAME;
+
+private:
+  struct PendingRebroadcast
+  {
+    scheduler::EventId event;
+    weak_ptr<pit::Entry> pitEntry;
+    FaceId inFaceId;
+    // number of times the Interest has been heard
+    unsigned int count;
+  };
+
+  time::milliseconds m_maxDelay;
+  unsigned int m_threshold;
+
+  // deferred rebroadcasts <(name, Nonce), rebroadcast>
+  std::map<RebroadcastKey, PendingRebroadcast> m_pending;
+
+  ns3::Ptr<ns3::UniformRandomVariable> m_random;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_COUNTER_BROADCAST_STRATEGY_HPP
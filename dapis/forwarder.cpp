@@ -27,6 +27,7 @@
 #include "algorithm.hpp"
 #include "best-route-strategy2.hpp"
 #include "strategy.hpp"
+#include "traffic-manager.hpp"
 #include "core/logger.hpp"
 #include "table/cleanup.hpp"
 #include <ndn-cxx/lp/tags.hpp>
@@ -43,6 +44,25 @@ getDefaultStrategyName()
   return fw::BestRouteStrategy2::getStrategyName();
 }
 
+// traffic managers of the forwarders, identified by their face table. The
+// manager of a forwarder is destroyed with the forwarder
+static std::unordered_map<const FaceTable*, unique_ptr<fw::TrafficManager>>&
+getTrafficManagers()
+{
+  static std::unordered_map<const FaceTable*, unique_ptr<fw::TrafficManager>> managers;
+  return managers;
+}
+
+static fw::TrafficManager&
+getTrafficManager(FaceTable& faceTable, PacketCounter& nOutData)
+{
+  unique_ptr<fw::TrafficManager>& manager = getTrafficManagers()[&faceTable];
+  if (manager == nullptr) {
+    manager = make_unique<fw::TrafficManager>(faceTable, nOutData);
+  }
+  return *manager;
+}
+
 Forwarder::Forwarder()
   : m_unsolicitedDataPolicy(new fw::DefaultUnsolicitedDataPolicy())
   , m_fib(m_nameTree)
@@ -79,7 +99,13 @@ Forwarder::Forwarder()
   m_strategyChoice.setDefaultStrategy(getDefaultStrategyName());
 }
 
-Forwarder::~Forwarder() = default;
+Forwarder::~Forwarder()
+{
+  // the queued Data, the drain events and the face table connection of the
+  // traffic manager go before the face table, which a new forwarder may reuse
+  // the address of
+  getTrafficManagers().erase(&m_faceTable);
+}
 
 void
 Forwarder::onIncomingInterest(Face& inFace, const Interest& interest)
@@ -100,8 +126,16 @@ Forwarder::onIncomingInterest(Face& inFace, const Interest& interest)
     return;
   }
 
+  // An Interest relayed by a local application (the ad hoc forwarder) keeps the Nonce
+  // and the hop count it was received with, so that the other nodes recognize its
+  // copies: its Nonce is known, but it is not a loop. Local applications do not put
+  // a hop count on the Interests they originate, so these still get the loop checks.
+  bool isLocalRelay = inFace.getScope() == ndn::nfd::FACE_SCOPE_LOCAL &&
+                      interest.getTag<lp::HopCountTag>() != nullptr;
+
   // detect duplicate Nonce with Dead Nonce List
-  bool hasDuplicateNonceInDnl = m_deadNonceList.has(interest.getName(), interest.getNonce());
+  bool hasDuplicateNonceInDnl = !isLocalRelay &&
+                                m_deadNonceList.has(interest.getName(), interest.getNonce());
   if (hasDuplicateNonceInDnl) {
     // goto Interest loop pipeline
     this->onInterestLoop(inFace, interest);
@@ -121,7 +155,7 @@ Forwarder::onIncomingInterest(Face& inFace, const Interest& interest)
 
   // detect duplicate Nonce in PIT entry
   int dnw = fw::findDuplicateNonce(*pitEntry, interest.getNonce(), inFace);
-  bool hasDuplicateNonceInPit = dnw != fw::DUPLICATE_NONCE_NONE;
+  bool hasDuplicateNonceInPit = !isLocalRelay && dnw != fw::DUPLICATE_NONCE_NONE;
   if (inFace.getLinkType() == ndn::nfd::LINK_TYPE_POINT_TO_POINT) {
     // for p2p face: duplicate Nonce from same incoming face is not loop
     hasDuplicateNonceInPit = hasDuplicateNonceInPit && !(dnw & fw::DUPLICATE_NONCE_IN_SAME);
@@ -161,6 +195,9 @@ Forwarder::onIncomingInterest(Face& inFace, const Interest& interest)
 void
 Forwarder::onInterestLoop(Face& inFace, const Interest& interest)
 {
+  // let the strategy learn about the copies of an Interest
+  m_strategyChoice.findEffectiveStrategy(interest.getName()).afterReceiveLoopedInterest(inFace, interest);
+
   // if multi-access or ad hoc face, drop
   if (inFace.getLinkType() != ndn::nfd::LINK_TYPE_POINT_TO_POINT) {
     NFD_LOG_DEBUG("onInterestLoop face=" << inFace.getId() <<
@@ -410,11 +447,8 @@ Forwarder::onOutgoingData(const Data& data, Face& outFace)
     return;
   }
 
-  // TODO traffic manager
-
-  // send Data
-  outFace.sendData(data);
-  ++m_counters.nOutData;
+  // send Data, paced by the traffic manager, which counts it once it is sent
+  getTrafficManager(m_faceTable, m_counters.nOutData).sendData(outFace, data);
 }
 
 void
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "load-spreading-strategy.hpp"
+#include "algorithm.hpp"
+#include "core/logger.hpp"
+
+namespace nfd {
+namespace fw {
+
+const Name LoadSpreadingStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/load-spreading/%FD%01");
+NFD_LOG_INIT("LoadSpreadingStrategy");
+NFD_REGISTER_STRATEGY(LoadSpreadingStrategy);
+
+
+LoadSpreadingStrategy::FaceStats::FaceStats()
+  : rttWeight(0)
+  , srtt(0)
+  , hasSample(false)
+  , currentWeight(0)
+{
+}
+
+LoadSpreadingStrategy::LoadSpreadingStrategy(Forwarder& forwarder, const Name& name)
+  : Strategy(forwarder, name)
+  , m_failoverTimeout(500)
+{
+  for (const auto& parameter : parseParameters(parseInstanceName(name).parameters)) {
+    const std::string& key = parameter.first;
+    unsigned long value = parameter.second;
+    if (key == "failover") {
+      m_failoverTimeout = time::milliseconds(value);
+    }
+    else {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("LoadSpreadingStrategy does not accept parameter " + key));
+    }
+  }
+  this->setInstanceName(makeInstanceName(name, getStrategyName()));
+}
+
+const Name&
+LoadSpreadingStrategy::getStrategyName()
+{
+  return STRATEGY_NAME;
+}
+
+void
+LoadSpreadingStrategy::afterReceiveInterest(const Face& inFace, const Interest& interest,
+                                            const shared_ptr<pit::Entry>& pitEntry)
+{
+  // a retransmission goes to a nexthop that has not been tried yet, if any
+  if (!this->sendToNextNexthop(pitEntry, inFace, interest, true)) {
+    NFD_LOG_DEBUG(interest << " from=" << inFace.getId() << " noNextHop");
+    this->rejectPendingInterest(pitEntry);
+  }
+}
+
+void
+LoadSpreadingStrategy::beforeSatisfyInterest(const shared_ptr<pit::Entry>& pitEntry,
+                                             const Face& inFace, const Data& data)
+{
+  InterestInfo* interestInfo = pitEntry->getStrategyInfo<InterestInfo>();
+  if (interestInfo != nullptr) {
+    interestInfo->failover.cancel();
+  }
+
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  auto outRecord = pitEntry->getOutRecord(inFace);
+  if (info == nullptr || outRecord == pitEntry->out_end()) {
+    return;
+  }
+
+  time::nanoseconds rtt = time::steady_clock::now() - outRecord->getLastRenewed();
+  double seconds = std::max(time::duration_cast<time::duration<double>>(rtt).count(), 1e-6);
+  double rttWeight = data.wireEncode().size() / seconds;
+
+  FaceStats& stats = info->faces[inFace.getId()];
+  if (stats.hasSample) {
+    stats.rttWeight += EWMA_ALPHA * (rttWeight - stats.rttWeight);
+    stats.srtt += time::duration_cast<time::nanoseconds>(EWMA_ALPHA * (rtt - stats.srtt));
+  }
+  else {
+    stats.rttWeight = rttWeight;
+    stats.srtt = rtt;
+    stats.hasSample = true;
+  }
+  NFD_LOG_DEBUG(data.getName() << " from=" << inFace.getId() << " rtt=" << rtt <<
+                " weight=" << stats.rttWeight);
+}
+
+void
+LoadSpreadingStrategy::beforeExpirePendingInterest(const shared_ptr<pit::Entry>& pitEntry)
+{
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  if (info == nullptr) {
+    return;
+  }
+
+  for (const pit::OutRecord& outRecord : pitEntry->getOutRecords()) {
+    info->faces[outRecord.getFace().getId()].rttWeight /= 2;
+  }
+}
+
+Face*
+LoadSpreadingStrategy::pickNexthop(NamespaceInfo& info, const std::vector<Face*>& candidates)
+{
+  // nexthops without a sample weigh as much as the average measured nexthop
+  double sampledWeight = 0;
+  size_t nSampled = 0;
+  for (const Face* face : candidates) {
+    const FaceStats& stats = info.faces[face->getId()];
+    if (stats.hasSample) {
+      sampledWeight += stats.rttWeight;
+      nSampled++;
+    }
+  }
+  double defaultWeight = (nSampled == 0 || sampledWeight <= 0) ? 1 : sampledWeight / nSampled;
+
+  // smooth weighted round-robin: every nexthop gains its weight, the one
+  // ahead is picked and loses the total weight
+  double totalWeight = 0;
+  Face* picked = nullptr;
+  FaceStats* pickedStats = nullptr;
+  for (Face* face : candidates) {
+    FaceStats& stats = info.faces[face->getId()];
+    double weight = stats.hasSample ? stats.rttWeight : defaultWeight;
+    stats.currentWeight += weight;
+    totalWeight += weight;
+    if (pickedStats == nullptr || stats.currentWeight > pickedStats->currentWeight) {
+      picked = face;
+      pickedStats = &stats;
+    }
+  }
+  pickedStats->currentWeight -= totalWeight;
+  return picked;
+}
+
+bool
+LoadSpreadingStrategy::sendToNextNexthop(const shared_ptr<pit::Entry>& pitEntry, const Face& inFace,
+                                         const Interest& interest, bool allowTried)
+{
+  const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
+  std::vector<Face*> candidates;
+  std::vector<Face*> untried;
+  for (const fib::NextHop& nexthop : fibEntry.getNextHops()) {
+    Face& outFace = nexthop.getFace();
+    if (&outFace == &inFace || wouldViolateScope(inFace, interest, outFace)) {
+      continue;
+    }
+    candidates.push_back(&outFace);
+    if (pitEntry->getOutRecord(outFace) == pitEntry->out_end()) {
+      untried.push_back(&outFace);
+    }
+  }
+
+  const std::vector<Face*>& choices = (untried.empty() && allowTried) ? candidates : untried;
+  if (choices.empty()) {
+    return false;
+  }
+
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  Face* outFace = info == nullptr ? choices.front() : this->pickNexthop(*info, choices);
+  NFD_LOG_DEBUG(interest << " from=" << inFace.getId() << " to=" << outFace->getId());
+  this->sendInterest(pitEntry, *outFace, interest);
+
+  time::nanoseconds timeout = m_failoverTimeout;
+  if (info != nullptr && info->faces[outFace->getId()].hasSample) {
+    timeout = 2 * info->faces[outFace->getId()].srtt;
+  }
+  InterestInfo* interestInfo = pitEntry->insertStrategyInfo<InterestInfo>().first;
+  interestInfo->failover = scheduler::schedule(timeout, bind(&LoadSpreadingStrategy::onFailoverTimeout, this,
+                                                             weak_ptr<pit::Entry>(pitEntry), outFace->getId()));
+  return true;
+}
+
+void
+LoadSpreadingStrategy::onFailoverTimeout(weak_ptr<pit::Entry> pitEntryWeak, FaceId faceId)
+{
+  shared_ptr<pit::Entry> pitEntry = pitEntryWeak.lock();
+  if (pitEntry == nullptr || pitEntry->getInRecords().empty()) {
+    return;
+  }
+
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  if (info != nullptr) {
+    info->faces[faceId].rttWeight /= 2;
+  }
+
+  const pit::InRecord& inRecord = pitEntry->getInRecords().front();
+  NFD_LOG_DEBUG(pitEntry->getName() << " failover from=" << faceId);
+  this->sendToNextNexthop(pitEntry, inRecord.getFace(), inRecord.getInterest(), false);
+}
+
+} // namespace fw
+} // namespace nfd
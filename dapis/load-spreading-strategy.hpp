@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_LOAD_SPREADING_STRATEGY_HPP
+#define NFD_DAEMON_FW_LOAD_SPREADING_STRATEGY_HPP
+
+#include "strategy.hpp"
+#include "core/scheduler.hpp"
+
+#include <unordered_map>
+
+namespace nfd {
+namespace fw {
+
+/** \brief a forwarding strategy that spreads the Interests of a torrent over its seeders
+ *
+ *  Consecutive Interests are sent to the nexthops in turn, by smooth weighted round-robin,
+ *  each nexthop being weighted by the moving average of Data size over RTT, recorded
+ *  in Measurements in the entry of the FIB prefix. This is the rate of a single Interest
+ *  in flight, so it mostly ranks the nexthops by RTT: it is not their measured
+ *  throughput, which would follow the share of Interests the weight gives them in the
+ *  first place. Nexthops without a sample get the mean weight of the others, so that
+ *  new seeders are used (and measured) right away.
+ *
+ *  When an Interest is not satisfied within twice the smoothed RTT of its nexthop, the
+ *  weight of the nexthop is halved and the Interest fails over to the next nexthop
+ *  that has not been tried yet. The failover timeout of nexthops without an RTT sample,
+ *  in milliseconds, is a parameter of the strategy instance name:
+ *  /localhost/nfd/strategy/load-spreading/%FD%01/failover~500
+ */
+class LoadSpreadingStrategy : public Strategy
+{
+public:
+  LoadSpreadingStrategy(Forwarder& forwarder, const Name& name = STRATEGY_NAME);
+
+  static const Name&
+  getStrategyName();
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       const shared_ptr<pit::Entry>& pitEntry) override;
+
+  virtual void
+  beforeSatisfyInterest(const shared_ptr<pit::Entry>& pitEntry,
+                        const Face& inFace, const Data& data) override;
+
+  virtual void
+  beforeExpirePendingInterest(const shared_ptr<pit::Entry>& pitEntry) override;
+
+public:
+  /** \brief weight and round-robin state of a nexthop
+   */
+  struct FaceStats
+  {
+    FaceStats();
+
+    double rttWeight; ///< EWMA of Data size / RTT, in bytes per second
+    time::nanoseconds srtt;
+    bool hasSample;
+    double currentWeight; ///< smooth weighted round-robin counter
+  };
+
+  /** \brief nexthops of a torrent namespace
+   */
+  class NamespaceInfo : public StrategyInfo
+  {
+  public:
+    static constexpr int
+    getTypeId()
+    {
+      return 9110;
+    }
+
+  public:
+    std::unordered_map<FaceId, FaceStats> faces;
+  };
+
+  /** \brief failover timer of a pending Interest
+   */
+  class InterestInfo : public StrategyInfo
+  {
+  public:
+    static constexpr int
+    getTypeId()
+    {
+      return 9111;
+    }
+
+  public:
+    scheduler::ScopedEventId failover;
+  };
+
+private:
+  /** \brief pick the nexthop of the next Interest among candidates (not empty)
+   */
+  Face*
+  pickNexthop(NamespaceInfo& info, const std::vector<Face*>& candidates);
+
+  /** \brief send the Interest to the next nexthop that has not been tried yet (or to
+   *         any nexthop if allowTried is set and all have been tried), and arm its
+   *         failover timer
+   *  \return false if no nexthop can be used
+   */
+  bool
+  sendToNextNexthop(const shared_ptr<pit::Entry>& pitEntry, const Face& inFace,
+                    const Interest& interest, bool allowTried);
+
+  void
+  onFailoverTimeout(weak_ptr<pit::Entry> pitEntry, FaceId faceId);
+
+public:
+  static const Name STRATEGY_NAME;
+
+private:
+  time::milliseconds m_failoverTimeout;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_LOAD_SPREADING_STRATEGY_HPP
@@ -27,6 +27,7 @@
 #include "forwarder.hpp"
 #include "core/logger.hpp"
 #include "core/random.hpp"
+#include <limits>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/algorithm/copy.hpp>
 
@@ -35,6 +36,8 @@ namespace fw {
 
 NFD_LOG_INIT("Strategy");
 
+constexpr double Strategy::EWMA_ALPHA;
+
 Strategy::Strategy(Forwarder& forwarder, const Name& name)
   : afterAddFace(forwarder.getFaceTable().afterAdd)
   , beforeRemoveFace(forwarder.getFaceTable().beforeRemove)
@@ -137,6 +140,26 @@ Strategy::parseInstanceName(const Name& input)
   return {input, ndn::nullopt, PartialName()};
 }
 
+std::map<std::string, unsigned long>
+Strategy::parseParameters(const PartialName& parameters)
+{
+  std::map<std::string, unsigned long> parsed;
+  for (const auto& component : parameters) {
+    std::string parameter = component.toUri();
+    size_t separator = parameter.find('~');
+    if (separator == std::string::npos) {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("Strategy parameter is not key~value: " + parameter));
+    }
+    std::string value = parameter.substr(separator + 1);
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos ||
+        value.size() > std::numeric_limits<unsigned long>::digits10) {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("Strategy parameter value is not a number: " + parameter));
+    }
+    parsed[parameter.substr(0, separator)] = std::stoul(value);
+  }
+  return parsed;
+}
+
 Name
 Strategy::makeInstanceName(const Name& input, const Name& strategyName)
 {
@@ -185,6 +208,12 @@ Strategy::onDroppedInterest(const Face& outFace, const Interest& interest)
   NFD_LOG_DEBUG("onDroppedInterest outFace=" << outFace.getId() << " name=" << interest.getName());
 }
 
+void
+Strategy::afterReceiveLoopedInterest(const Face& inFace, const Interest& interest)
+{
+  NFD_LOG_DEBUG("afterReceiveLoopedInterest inFace=" << inFace.getId() << " name=" << interest.getName());
+}
+
 void
 Strategy::sendNacks(const shared_ptr<pit::Entry>& pitEntry, const lp::NackHeader& header,
                     std::initializer_list<const Face*> exceptFaces)
@@ -190,6 +190,17 @@ public: // triggers
   virtual void
   onDroppedInterest(const Face& outFace, const Interest& interest);
 
+  /** \brief trigger after a looped Interest is received
+   *
+   *  The Interest has a Nonce already seen in the PIT entry or in the Dead Nonce List.
+   *  On an ad hoc face this usually means a neighbor has rebroadcast an Interest
+   *  this node has heard before.
+   *
+   *  In the base class this method does nothing.
+   */
+  virtual void
+  afterReceiveLoopedInterest(const Face& inFace, const Interest& interest);
+
 protected: // actions
   /** \brief send Interest to outFace
    *  \param pitEntry PIT entry
@@ -264,6 +275,27 @@ protected: // accessors
     return m_forwarder.getFaceTable();
   }
 
+protected: // measurements
+  /** \brief weight of a new sample in the moving averages kept in Measurements
+   */
+  static constexpr double EWMA_ALPHA = 0.125;
+
+  /** \brief get the StrategyInfo of type T in the Measurements entry of the FIB prefix of
+   *         a PIT entry, inserting it if needed, and keep the entry for another minute
+   *  \return the StrategyInfo, or nullptr if the Measurements entry is unavailable
+   */
+  template<typename T>
+  T*
+  getPrefixInfo(const pit::Entry& pitEntry)
+  {
+    measurements::Entry* me = this->getMeasurements().get(this->lookupFib(pitEntry));
+    if (me == nullptr) {
+      return nullptr;
+    }
+    this->getMeasurements().extendLifetime(*me, time::seconds(60));
+    return me->insertStrategyInfo<T>().first;
+  }
+
 protected: // instance name
   struct ParsedInstanceName
   {
@@ -279,6 +311,14 @@ protected: // instance name
   static ParsedInstanceName
   parseInstanceName(const Name& input);
 
+  /** \brief parse the key~value parameters of a strategy instance name
+   *  \param parameters parameter components, typically parseInstanceName(name).parameters
+   *  \return the numeric value of every key; a key given twice keeps its last value
+   *  \throw std::invalid_argument a parameter is not key~value, or its value is not a number
+   */
+  static std::map<std::string, unsigned long>
+  parseParameters(const PartialName& parameters);
+
   /** \brief construct a strategy instance name
    *  \param input strategy instance name, may contain version and parameters
    *  \param strategyName strategy name with version but without parameters;
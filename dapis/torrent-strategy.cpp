@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "torrent-strategy.hpp"
+#include "algorithm.hpp"
+#include "core/logger.hpp"
+
+namespace nfd {
+namespace fw {
+
+const Name TorrentStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/torrent/%FD%01");
+NFD_LOG_INIT("TorrentStrategy");
+NFD_REGISTER_STRATEGY(TorrentStrategy);
+
+// RTT assumed for a nexthop that has not returned any Data yet
+static const double UNKNOWN_RTT = 1.0;
+static const double MIN_SATISFACTION = 0.01;
+
+TorrentStrategy::FaceStats::FaceStats()
+  : satisfaction(1.0)
+  , srtt(0)
+  , hasRtt(false)
+{
+}
+
+TorrentStrategy::TorrentStrategy(Forwarder& forwarder, const Name& name)
+  : Strategy(forwarder, name)
+  , m_probe(10)
+  , m_random(ns3::CreateObject<ns3::UniformRandomVariable>())
+{
+  for (const auto& parameter : parseParameters(parseInstanceName(name).parameters)) {
+    const std::string& key = parameter.first;
+    unsigned long value = parameter.second;
+    if (key == "probe") {
+      m_probe = std::min<unsigned long>(value, 100);
+    }
+    else {
+      BOOST_THROW_EXCEPTION(std::invalid_argument("TorrentStrategy does not accept parameter " + key));
+    }
+  }
+  this->setInstanceName(makeInstanceName(name, getStrategyName()));
+}
+
+const Name&
+TorrentStrategy::getStrategyName()
+{
+  return STRATEGY_NAME;
+}
+
+void
+TorrentStrategy::afterReceiveInterest(const Face& inFace, const Interest& interest,
+                                      const shared_ptr<pit::Entry>& pitEntry)
+{
+  const fib::Entry& fibEntry = this->lookupFib(*pitEntry);
+  std::vector<Face*> candidates;
+  for (const fib::NextHop& nexthop : fibEntry.getNextHops()) {
+    Face& outFace = nexthop.getFace();
+    if (&outFace != &inFace && !wouldViolateScope(inFace, interest, outFace)) {
+      candidates.push_back(&outFace);
+    }
+  }
+
+  if (candidates.empty()) {
+    NFD_LOG_DEBUG(interest << " from=" << inFace.getId() << " noNextHop");
+    this->rejectPendingInterest(pitEntry);
+    return;
+  }
+
+  // best nexthops first, in FIB order on ties
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  if (info != nullptr) {
+    std::stable_sort(candidates.begin(), candidates.end(), [this, info] (const Face* a, const Face* b) {
+        return getCost(*info, a->getId()) < getCost(*info, b->getId());
+      });
+  }
+
+  // a retransmission goes to the best nexthop that has not been tried yet
+  Face* best = candidates.front();
+  for (Face* face : candidates) {
+    if (pitEntry->getOutRecord(*face) == pitEntry->out_end()) {
+      best = face;
+      break;
+    }
+  }
+  NFD_LOG_DEBUG(interest << " from=" << inFace.getId() << " to=" << best->getId());
+  this->sendInterest(pitEntry, *best, interest);
+
+  // keep measuring the other nexthops
+  if (candidates.size() > 1 && m_random->GetValue(0, 100) < m_probe) {
+    std::vector<Face*> others;
+    for (Face* face : candidates) {
+      if (face != best) {
+        others.push_back(face);
+      }
+    }
+    Face* probe = others[m_random->GetInteger(0, others.size() - 1)];
+    NFD_LOG_DEBUG(interest << " from=" << inFace.getId() << " probe=" << probe->getId());
+    this->sendInterest(pitEntry, *probe, interest);
+  }
+}
+
+void
+TorrentStrategy::beforeSatisfyInterest(const shared_ptr<pit::Entry>& pitEntry,
+                                       const Face& inFace, const Data& data)
+{
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  auto outRecord = pitEntry->getOutRecord(inFace);
+  if (info == nullptr || outRecord == pitEntry->out_end()) {
+    return;
+  }
+
+  time::nanoseconds rtt = time::steady_clock::now() - outRecord->getLastRenewed();
+  FaceStats& stats = info->faces[inFace.getId()];
+  stats.satisfaction += EWMA_ALPHA * (1.0 - stats.satisfaction);
+  if (stats.hasRtt) {
+    stats.srtt += time::duration_cast<time::nanoseconds>(EWMA_ALPHA * (rtt - stats.srtt));
+  }
+  else {
+    stats.srtt = rtt;
+    stats.hasRtt = true;
+  }
+  NFD_LOG_DEBUG(data.getName() << " from=" << inFace.getId() << " rtt=" << rtt <<
+                " srtt=" << stats.srtt << " satisfaction=" << stats.satisfaction);
+}
+
+void
+TorrentStrategy::beforeExpirePendingInterest(const shared_ptr<pit::Entry>& pitEntry)
+{
+  NamespaceInfo* info = getPrefixInfo<NamespaceInfo>(*pitEntry);
+  if (info == nullptr) {
+    return;
+  }
+
+  for (const pit::OutRecord& outRecord : pitEntry->getOutRecords()) {
+    FaceStats& stats = info->faces[outRecord.getFace().getId()];
+    stats.satisfaction -= EWMA_ALPHA * stats.satisfaction;
+    NFD_LOG_DEBUG(pitEntry->getName() << " expired to=" << outRecord.getFace().getId() <<
+                  " satisfaction=" << stats.satisfaction);
+  }
+}
+
+double
+TorrentStrategy::getCost(const NamespaceInfo& info, FaceId faceId) const
+{
+  FaceStats stats;
+  auto it = info.faces.find(faceId);
+  if (it != info.faces.end()) {
+    stats = it->second;
+  }
+
+  double rtt = stats.hasRtt ? time::duration_cast<time::duration<double>>(stats.srtt).count() : UNKNOWN_RTT;
+  return rtt / std::max(stats.satisfaction, MIN_SATISFACTION);
+}
+
+} // namespace fw
+} // namespace nfd
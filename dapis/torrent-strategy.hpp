@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_TORRENT_STRATEGY_HPP
+#define NFD_DAEMON_FW_TORRENT_STRATEGY_HPP
+
+#include "strategy.hpp"
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+
+namespace nfd {
+namespace fw {
+
+/** \brief a forwarding strategy that sends torrent Interests to the best performing nexthop
+ *
+ *  The satisfaction ratio and the round-trip time of every nexthop are recorded in
+ *  Measurements, in the entry of the FIB prefix (the torrent namespace). A new Interest
+ *  goes to the nexthop with the lowest expected time per satisfied Interest (RTT divided
+ *  by the satisfaction ratio), and in probe percent of the cases also to another random
+ *  nexthop so that the other nexthops keep being measured. A retransmission goes to the
+ *  best nexthop that has not been tried yet.
+ *
+ *  The probing percentage is a parameter of the strategy instance name:
+ *  /localhost/nfd/strategy/torrent/%FD%01/probe~10
+ */
+class TorrentStrategy : public Strategy
+{
+public:
+  TorrentStrategy(Forwarder& forwarder, const Name& name = STRATEGY_NAME);
+
+  static const Name&
+  getStrategyName();
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       const shared_ptr<pit::Entry>& pitEntry) override;
+
+  virtual void
+  beforeSatisfyInterest(const shared_ptr<pit::Entry>& pitEntry,
+                        const Face& inFace, const Data& data) override;
+
+  virtual void
+  beforeExpirePendingInterest(const shared_ptr<pit::Entry>& pitEntry) override;
+
+public:
+  /** \brief performance of a nexthop
+   */
+  struct FaceStats
+  {
+    FaceStats();
+
+    double satisfaction; ///< EWMA of the satisfied (1) and expired (0) Interests
+    time::nanoseconds srtt;
+    bool hasRtt;
+  };
+
+  /** \brief performance of the nexthops of a torrent namespace
+   */
+  class NamespaceInfo : public StrategyInfo
+  {
+  public:
+    static constexpr int
+    getTypeId()
+    {
+      return 9100;
+    }
+
+  public:
+    std::unordered_map<FaceId, FaceStats> faces;
+  };
+
+private:
+  /** \return expected time per satisfied Interest of a nexthop, in seconds
+   */
+  double
+  getCost(const NamespaceInfo& info, FaceId faceId) const;
+
+public:
+  static const Name STRATEGY_NAME;
+
+private:
+  unsigned int m_probe;
+
+  ns3::Ptr<ns3::UniformRandomVariable> m_random;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_TORRENT_STRATEGY_HPP
@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "traffic-manager.hpp"
+#include "core/logger.hpp"
+
+#include "ns3/global-value.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+
+#include <cmath>
+
+namespace nfd {
+namespace fw {
+
+NFD_LOG_INIT("TrafficManager");
+
+static ns3::GlobalValue g_trafficManagerRate("TrafficManagerRate",
+                                             "Pacing rate of the Data sent on every face to other nodes, 0bps for no pacing",
+                                             ns3::DataRateValue(ns3::DataRate("0bps")),
+                                             ns3::MakeDataRateChecker());
+
+static ns3::GlobalValue g_trafficManagerBurst("TrafficManagerBurst",
+                                              "Bytes of Data a face may send back to back",
+                                              ns3::UintegerValue(4400),
+                                              ns3::MakeUintegerChecker<uint32_t>(1));
+
+static ns3::GlobalValue g_trafficManagerQueueSize("TrafficManagerQueueSize",
+                                                  "Number of Data packets waiting for a face",
+                                                  ns3::UintegerValue(50),
+                                                  ns3::MakeUintegerChecker<uint32_t>());
+
+TrafficManager::TrafficManager(FaceTable& faceTable, PacketCounter& nOutData)
+  : m_faceTable(faceTable)
+  , m_nOutData(nOutData)
+{
+  ns3::DataRateValue rate;
+  g_trafficManagerRate.GetValue(rate);
+  m_rate = rate.Get().GetBitRate() / 8.0;
+
+  ns3::UintegerValue value;
+  g_trafficManagerBurst.GetValue(value);
+  m_burst = value.Get();
+  g_trafficManagerQueueSize.GetValue(value);
+  m_queueSize = value.Get();
+
+  m_beforeRemoveFace = m_faceTable.beforeRemove.connect([this] (Face& face) {
+    m_queues.erase(face.getId());
+  });
+}
+
+bool
+TrafficManager::isControl(const Data& data)
+{
+  const Name& name = data.getName();
+  return !name.empty() && (name.get(0) == name::Component("beacon") ||
+                           name.get(0) == name::Component("bitmap"));
+}
+
+void
+TrafficManager::sendData(Face& outFace, const Data& data)
+{
+  // local applications are not on the shared channel
+  if (!isEnabled() || outFace.getScope() == ndn::nfd::FACE_SCOPE_LOCAL) {
+    outFace.sendData(data);
+    ++m_nOutData;
+    return;
+  }
+
+  bool isNewFace = m_queues.count(outFace.getId()) == 0;
+  FaceQueue& queue = m_queues[outFace.getId()];
+  if (isNewFace) {
+    queue.tokens = m_burst;
+    queue.lastRefill = time::steady_clock::now();
+  }
+  refill(queue);
+
+  size_t size = data.wireEncode().size();
+  if (queue.control.empty() && queue.bulk.empty() && canSend(queue, size)) {
+    queue.tokens -= size;
+    outFace.sendData(data);
+    ++m_nOutData;
+    return;
+  }
+
+  bool isControlData = isControl(data);
+  if (queue.control.size() + queue.bulk.size() >= m_queueSize) {
+    if (!isControlData || queue.bulk.empty()) {
+      NFD_LOG_DEBUG("sendData face=" << outFace.getId() << " data=" << data.getName() << " queue-full");
+      return;
+    }
+    NFD_LOG_DEBUG("sendData face=" << outFace.getId() << " data=" << queue.bulk.back()->getName() <<
+                  " evicted");
+    queue.bulk.pop_back();
+  }
+
+  // a drain is scheduled as long as the queue is not empty
+  bool wasEmpty = queue.control.empty() && queue.bulk.empty();
+  (isControlData ? queue.control : queue.bulk).push_back(data.shared_from_this());
+  if (wasEmpty) {
+    drain(outFace.getId());
+  }
+}
+
+void
+TrafficManager::refill(FaceQueue& queue)
+{
+  time::steady_clock::TimePoint now = time::steady_clock::now();
+  double elapsed = time::duration_cast<time::duration<double>>(now - queue.lastRefill).count();
+  queue.tokens = std::min(m_burst, queue.tokens + elapsed * m_rate);
+  queue.lastRefill = now;
+}
+
+bool
+TrafficManager::canSend(const FaceQueue& queue, size_t size) const
+{
+  // a packet larger than the burst is sent with a full bucket
+  return queue.tokens >= std::min<double>(size, m_burst);
+}
+
+void
+TrafficManager::drain(FaceId faceId)
+{
+  auto it = m_queues.find(faceId);
+  Face* face = m_faceTable.get(faceId);
+  if (it == m_queues.end() || face == nullptr) {
+    return;
+  }
+  FaceQueue& queue = it->second;
+  refill(queue);
+
+  while (!queue.control.empty() || !queue.bulk.empty()) {
+    auto& packets = queue.control.empty() ? queue.bulk : queue.control;
+    size_t size = packets.front()->wireEncode().size();
+    if (!canSend(queue, size)) {
+      // rounded up to a whole nanosecond, so that the face has earned some
+      // tokens by the time the drain runs again
+      double wait = (std::min<double>(size, m_burst) - queue.tokens) / m_rate;
+      time::nanoseconds delay(std::max<time::nanoseconds::rep>(1, static_cast<time::nanoseconds::rep>(std::ceil(wait * 1e9))));
+      queue.drain = scheduler::schedule(delay, bind(&TrafficManager::drain, this, faceId));
+      return;
+    }
+    queue.tokens -= size;
+    face->sendData(*packets.front());
+    ++m_nOutData;
+    packets.pop_front();
+  }
+}
+
+} // namespace fw
+} // namespace nfd
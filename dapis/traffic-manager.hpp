@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014-2016,  Regents of the University of California,
+ *                           Arizona Board of Regents,
+ *                           Colorado State University,
+ *                           University Pierre & Marie Curie, Sorbonne University,
+ *                           Washington University in St. Louis,
+ *                           Beijing Institute of Technology,
+ *                           The University of Memphis.
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_TRAFFIC_MANAGER_HPP
+#define NFD_DAEMON_FW_TRAFFIC_MANAGER_HPP
+
+#include "face/face.hpp"
+#include "face/face-table.hpp"
+#include "core/counter.hpp"
+#include "core/scheduler.hpp"
+
+#include <deque>
+#include <unordered_map>
+
+namespace nfd {
+namespace fw {
+
+/** \brief paces the Data sent to other nodes
+ *
+ *  Every non-local face gets a token bucket of rate bytes per second holding up to
+ *  burst bytes. Data that cannot be sent right away waits in the queue of the face,
+ *  control Data (beacons and bitmaps) being sent before bulk Data (pieces). When
+ *  the queue holds queueSize packets, control Data evicts the newest bulk Data and
+ *  other Data is dropped.
+ *
+ *  The configuration is read from the ns-3 global values TrafficManagerRate
+ *  (0bps, the default, disables pacing), TrafficManagerBurst and TrafficManagerQueueSize,
+ *  which the scenarios bind before the simulation starts.
+ *
+ *  Data is counted in nOutData of the forwarder when it is handed to the face, so that
+ *  dropped and evicted Data is not.
+ */
+class TrafficManager : noncopyable
+{
+public:
+  TrafficManager(FaceTable& faceTable, PacketCounter& nOutData);
+
+  /** \brief send Data to a face, now or once the face has the tokens for it
+   */
+  void
+  sendData(Face& outFace, const Data& data);
+
+  bool
+  isEnabled() const
+  {
+    return m_rate > 0;
+  }
+
+private:
+  struct FaceQueue
+  {
+    double tokens; ///< bytes, may be negative after a packet larger than the burst
+    time::steady_clock::TimePoint lastRefill;
+    std::deque<shared_ptr<const Data>> control;
+    std::deque<shared_ptr<const Data>> bulk;
+    scheduler::ScopedEventId drain;
+  };
+
+  static bool
+  isControl(const Data& data);
+
+  void
+  refill(FaceQueue& queue);
+
+  /** \brief whether the face has the tokens to send size bytes now
+   */
+  bool
+  canSend(const FaceQueue& queue, size_t size) const;
+
+  /** \brief send the queued Data the face has the tokens for, and schedule the next drain
+   */
+  void
+  drain(FaceId faceId);
+
+private:
+  FaceTable& m_faceTable;
+  PacketCounter& m_nOutData;
+  double m_rate; ///< bytes per second
+  double m_burst; ///< bytes
+  size_t m_queueSize; ///< packets
+
+  std::unordered_map<FaceId, FaceQueue> m_queues;
+  signal::ScopedConnection m_beforeRemoveFace;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_TRAFFIC_MANAGER_HPP
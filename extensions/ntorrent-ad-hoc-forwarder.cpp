@@ -44,7 +44,29 @@ NTorrentAdHocForwarder::GetTypeId(void)
       .AddAttribute("ExpirationTimer", "Timer for an outstanding Interest to expire", StringValue("30ms"),
                     MakeTimeAccessor(&NTorrentAdHocForwarder::m_expirationTimer), MakeTimeChecker())
       .AddAttribute("ForwardProbability", "Probability packet is forwarded.", IntegerValue(0),
-                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_forwardProbability), MakeIntegerChecker<int32_t>());
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_forwardProbability), MakeIntegerChecker<int32_t>())
+      // Gossip mode: relay with probability TargetRebroadcasters / number of neighbors, so that dense
+      // regions stop flooding (0 keeps the fixed ForwardProbability)
+      .AddAttribute("TargetRebroadcasters", "Number of neighbors expected to relay a packet", IntegerValue(0),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_targetRebroadcasters), MakeIntegerChecker<uint32_t>())
+      .AddAttribute("MinForwardProbability", "Lowest probability (percent) of relaying a packet in gossip mode", IntegerValue(10),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_minForwardProbability), MakeIntegerChecker<uint32_t>(0, 100))
+      // A node is a neighbor until NeighborTimeout after its last beacon or bitmap
+      .AddAttribute("NeighborTimeout", "Time after which a silent neighbor is forgotten", StringValue("5s"),
+                    MakeTimeAccessor(&NTorrentAdHocForwarder::m_neighborTimeout), MakeTimeChecker())
+      // Packets are not relayed once they have travelled the hop limit of their class (0 for no limit)
+      .AddAttribute("BeaconHopLimit", "Number of hops a beacon may travel", IntegerValue(0),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_beaconHopLimit), MakeIntegerChecker<uint32_t>())
+      .AddAttribute("BitmapHopLimit", "Number of hops a bitmap may travel", IntegerValue(0),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_bitmapHopLimit), MakeIntegerChecker<uint32_t>())
+      .AddAttribute("PieceHopLimit", "Number of hops a torrent piece Interest or Data may travel", IntegerValue(0),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_pieceHopLimit), MakeIntegerChecker<uint32_t>())
+      // Number of recently heard packets remembered to drop their copies (0 to disable)
+      .AddAttribute("DuplicateCacheSize", "Number of recently heard packets remembered", IntegerValue(1000),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_duplicateCacheSize), MakeIntegerChecker<uint32_t>())
+      // Number of relayed torrent pieces kept to answer Interests locally (0 to disable)
+      .AddAttribute("RelayCacheSize", "Number of relayed torrent pieces cached", IntegerValue(100),
+                    MakeIntegerAccessor(&NTorrentAdHocForwarder::m_relayCacheSize), MakeIntegerChecker<uint32_t>());
     return tid;
 }
 
@@ -70,6 +92,10 @@ NTorrentAdHocForwarder::StartApplication()
     m_random = CreateObject<UniformRandomVariable>();
     m_random->SetAttribute("Min", DoubleValue(0.0));
     m_random->SetAttribute("Max", DoubleValue(m_randomTimerRange.GetMilliSeconds()));
+
+    m_duplicates.SetCapacity(m_duplicateCacheSize);
+    m_relayCache.SetCapacity(m_relayCacheSize);
+    m_density.SetTimeout(m_neighborTimeout);
 }
 
 void
@@ -83,11 +109,55 @@ NTorrentAdHocForwarder::SendInterest()
 {
 }
 
+bool
+NTorrentAdHocForwarder::IsPieceName(const Name& name)
+{
+  if (name.empty())
+    return false;
+  std::string type = name.get(0).toUri();
+  return type != "beacon" && type != "bitmap";
+}
+
+bool
+NTorrentAdHocForwarder::ShouldForward()
+{
+  unsigned int chosenProb = rand() % 100 + 1;
+  if (m_targetRebroadcasters == 0) {
+    return chosenProb >= m_forwardProbability;
+  }
+
+  uint32_t forwardProbability = m_density.GetForwardProbability(m_targetRebroadcasters, m_minForwardProbability,
+                                                                Simulator::Now());
+  NS_LOG_DEBUG("Forward probability: " << forwardProbability);
+  return chosenProb <= forwardProbability;
+}
+
+bool
+NTorrentAdHocForwarder::IsWithinHopLimit(const Name& name, const ::ndn::TagHost& packet) const
+{
+  uint32_t hopLimit = m_pieceHopLimit;
+  std::string type = name.empty() ? "" : name.get(0).toUri();
+  if (type == "beacon")
+    hopLimit = m_beaconHopLimit;
+  else if (type == "bitmap")
+    hopLimit = m_bitmapHopLimit;
+
+  // the link service counts the hops travelled by the packets it receives,
+  // and relayed packets keep the tag
+  shared_ptr<lp::HopCountTag> hopCount = packet.getTag<lp::HopCountTag>();
+  if (hopLimit == 0 || hopCount == nullptr)
+    return true;
+  return *hopCount < hopLimit;
+}
+
 void
 NTorrentAdHocForwarder::ForwardInterest(shared_ptr<const Interest> interest)
 {
   Name interestName = interest->getName();
-  shared_ptr<Interest> interestForwarded = make_shared<Interest>(interestName);
+  // Keep the Nonce (and the hop count), so that the other nodes recognize the
+  // copies. The forwarder does not take the relayed copy, which carries a hop
+  // count, for a loop
+  shared_ptr<Interest> interestForwarded = make_shared<Interest>(*interest);
   NS_LOG_DEBUG("Forwarding Interest. (" + interestName.toUri() + ")");
 
   m_transmittedInterests(interestForwarded, this, m_face);
@@ -107,12 +177,33 @@ NTorrentAdHocForwarder::OnInterest(shared_ptr<const Interest> interest)
   ndn::App::OnInterest(interest);
 
   Name interestName = interest->getName();
+  m_density.Observe(*interest, Simulator::Now());
 
-  // Decide whether to forward or not
-  unsigned int chosenProb = rand() % 100 + 1;
+  // Copies of an Interest heard before (from other neighbors, or relayed by
+  // ourselves) are dropped
+  if (!m_duplicates.Insert(DuplicateCache::GetKey(*interest))) {
+    NS_LOG_DEBUG("Dropping duplicate Interest. [" + interestName.toUri() + "]");
+    return;
+  }
+
+  // Answer the Interest for a piece we have relayed
+  if (IsPieceName(interestName)) {
+    shared_ptr<const Data> data = m_relayCache.Find(interestName);
+    if (data != nullptr) {
+      NS_LOG_DEBUG("Answering Interest from the relay cache. [" + interestName.toUri() + "]");
+      Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocForwarder::ForwardData, this, data);
+      return;
+    }
+  }
 
+  if (!IsWithinHopLimit(interestName, *interest)) {
+    NS_LOG_DEBUG("Interest reached its hop limit. [" + interestName.toUri() + "]");
+    return;
+  }
+
+  // Decide whether to forward or not
   NS_LOG_DEBUG("Deciding whether to forward Interest or not. [" + interestName.toUri() + "]");
-  if (chosenProb >= m_forwardProbability) {
+  if (ShouldForward()) {
     // Forward Interest
     Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocForwarder::ForwardInterest, this, interest);
   } else {
@@ -124,11 +215,23 @@ NTorrentAdHocForwarder::OnInterest(shared_ptr<const Interest> interest)
 void
 NTorrentAdHocForwarder::OnData(shared_ptr<const Data> data)
 {
-  // Decide whether to forward or not
-  unsigned int chosenProb = rand() % 100 + 1;
+  if (!m_duplicates.Insert(DuplicateCache::GetKey(*data))) {
+    NS_LOG_DEBUG("Dropping duplicate Data. [" + data->getName().toUri() + "]");
+    return;
+  }
+
+  if (IsPieceName(data->getName())) {
+    m_relayCache.Insert(data);
+  }
 
+  if (!IsWithinHopLimit(data->getName(), *data)) {
+    NS_LOG_DEBUG("Data reached its hop limit. [" + data->getName().toUri() + "]");
+    return;
+  }
+
+  // Decide whether to forward or not
   NS_LOG_DEBUG("Deciding whether to forward Data or not. [" + data->getName().toUri() + "]");
-  if (chosenProb >= m_forwardProbability) {
+  if (ShouldForward()) {
     Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocForwarder::ForwardData, this, data);
   } else {
     ;
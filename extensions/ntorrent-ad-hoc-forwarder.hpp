@@ -21,6 +21,7 @@
 
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/encoding/tlv.hpp>
+#include <ndn-cxx/lp/tags.hpp>
 
 #include "ns3/ndnSIM-module.h"
 #include "ns3/integer.h"
@@ -38,6 +39,10 @@
 #include "NFD/rib/rib-manager.hpp"
 #include "ns3/ndnSIM/helper/ndn-strategy-choice-helper.hpp"
 
+#include "ntorrent-duplicate-cache.hpp"
+#include "ntorrent-neighbor-density.hpp"
+#include "ntorrent-relay-cache.hpp"
+
 namespace ns3 {
 namespace ndn {
 
@@ -72,13 +77,58 @@ public:
   ForwardData(shared_ptr<const Data> data);
 
 private:
+  /**
+   * @brief is this the name of a torrent piece (not of a beacon or a bitmap)
+   */
+  static bool
+  IsPieceName(const Name& name);
+
+  /**
+   * @brief random decision to relay a packet, with the fixed probability or
+   * with the probability derived from the neighbor density
+   */
+  bool
+  ShouldForward();
+
+  /**
+   * @brief check the hop count of a received packet against the hop limit of
+   * its class (beacon, bitmap or piece)
+   * @return false if the packet must not be relayed any further
+   */
+  bool
+  IsWithinHopLimit(const Name& name, const ::ndn::TagHost& packet) const;
+
   uint32_t m_forwardProbability;
   uint32_t m_nodeId;
 
+  // number of neighbors that should relay a packet (0 to use the fixed
+  // ForwardProbability), and lowest probability of relaying, in percent
+  uint32_t m_targetRebroadcasters;
+  uint32_t m_minForwardProbability;
+  Time m_neighborTimeout;
+
+  // senders of the beacons and bitmaps heard recently
+  NeighborDensity m_density;
+
+  // number of wireless hops a packet of each class may travel (0 for no limit)
+  uint32_t m_beaconHopLimit;
+  uint32_t m_bitmapHopLimit;
+  uint32_t m_pieceHopLimit;
+
   Time m_randomTimerRange;
   Time m_expirationTimer;
 
   Ptr<RandomVariableStream> m_random;
+
+  // Interests and Data packets already heard, so that every packet is
+  // considered for relaying only once
+  DuplicateCache m_duplicates;
+  uint32_t m_duplicateCacheSize;
+
+  // pieces relayed recently, to answer the Interests of the neighbors
+  // without fetching the pieces again
+  RelayCache m_relayCache;
+  uint32_t m_relayCacheSize;
 };
 
 } // namespace ndn
@@ -23,17 +23,18 @@
 
 NS_LOG_COMPONENT_DEFINE("NTorrentAdHocAppNaive");
 
-// custom comparator for scarcity pairs
-bool compare_pairs (const std::pair<uint32_t, uint32_t> first, const std::pair<uint32_t, uint32_t> second)
-{
-  return (std::get<1>(first) > std::get<1>(second));
-}
-
 namespace ns3 {
 namespace ndn {
 
 NS_OBJECT_ENSURE_REGISTERED(NTorrentAdHocAppNaive);
 
+// torrent prefixes are plain text name components, so use their value as is
+static std::string
+getComponentValue(const ::ndn::name::Component& component)
+{
+  return std::string(reinterpret_cast<const char*>(component.value()), component.value_size());
+}
+
 TypeId
 NTorrentAdHocAppNaive::GetTypeId(void)
 {
@@ -58,9 +59,43 @@ NTorrentAdHocAppNaive::GetTypeId(void)
                     // Random timer between 0 and RandomTimerRange
       .AddAttribute("ExpirationTimer", "Timer for an outstanding Interest to expire", StringValue("30ms"),
                     MakeTimeAccessor(&NTorrentAdHocAppNaive::m_expirationTimer), MakeTimeChecker())
+      // Bounds of the retransmission timeout computed from the RTT of a neighbor
+      .AddAttribute("MinRto", "Minimum retransmission timeout", StringValue("5ms"),
+                    MakeTimeAccessor(&NTorrentAdHocAppNaive::m_minRto), MakeTimeChecker())
+      .AddAttribute("MaxRto", "Maximum retransmission timeout", StringValue("2s"),
+                    MakeTimeAccessor(&NTorrentAdHocAppNaive::m_maxRto), MakeTimeChecker())
+      .AddAttribute("MaxRetransmissions", "Retransmissions of a piece Interest before giving up", IntegerValue(3),
+                    MakeIntegerAccessor(&NTorrentAdHocAppNaive::m_maxRetransmissions), MakeIntegerChecker<uint32_t>())
+      // A neighbor whose bitmap advertisements have not been heard for NeighborTimeout
+      // no longer constrains the base version of our delta advertisements
+      .AddAttribute("NeighborTimeout", "Time after which a silent neighbor is ignored", StringValue("5s"),
+                    MakeTimeAccessor(&NTorrentAdHocAppNaive::m_neighborTimeout), MakeTimeChecker())
+      // Pipelining of piece Interests towards a neighbor
+      .AddAttribute("InitialWindow", "Initial number of outstanding piece Interests per neighbor", IntegerValue(4),
+                    MakeIntegerAccessor(&NTorrentAdHocAppNaive::m_initialWindow), MakeIntegerChecker<uint32_t>(1))
+      .AddAttribute("MaxWindow", "Maximum number of outstanding piece Interests per neighbor", IntegerValue(32),
+                    MakeIntegerAccessor(&NTorrentAdHocAppNaive::m_maxWindow), MakeIntegerChecker<uint32_t>(1))
+      .AddAttribute("EndgameThreshold", "Number of missing pieces below which pieces are requested from every neighbor", IntegerValue(10),
+                    MakeIntegerAccessor(&NTorrentAdHocAppNaive::m_endgameThreshold), MakeIntegerChecker<uint32_t>())
+      // How long an overheard torrent prefix is remembered after it was last heard
+      .AddAttribute("OverheardExpireTime", "Lifetime of an overheard torrent prefix", StringValue("200ms"),
+                    MakeTimeAccessor(&NTorrentAdHocAppNaive::m_expireTime), MakeTimeChecker())
       // Is this node the original torrent producer or just a peer?
       .AddAttribute("TorrentProducer", "Has this node generated the torrent?", BooleanValue(false),
-                    MakeBooleanAccessor(&NTorrentAdHocAppNaive::m_isTorrentProducer), MakeBooleanChecker());
+                    MakeBooleanAccessor(&NTorrentAdHocAppNaive::m_isTorrentProducer), MakeBooleanChecker())
+
+      .AddTraceSource("RttEstimate", "RTT sample and updated estimator state of a neighbor",
+                      MakeTraceSourceAccessor(&NTorrentAdHocAppNaive::m_rttEstimate),
+                      "ns3::ndn::NTorrentAdHocAppNaive::RttEstimateCallback")
+      .AddTraceSource("InterestTimeout", "Timeout of a piece Interest and the backed off timeout",
+                      MakeTraceSourceAccessor(&NTorrentAdHocAppNaive::m_interestTimeout),
+                      "ns3::ndn::NTorrentAdHocAppNaive::InterestTimeoutCallback")
+      .AddTraceSource("EndgameRequest", "Re-broadcast, in endgame mode, of the Interest of a piece already requested from another neighbor",
+                      MakeTraceSourceAccessor(&NTorrentAdHocAppNaive::m_endgameRequest),
+                      "ns3::ndn::NTorrentAdHocAppNaive::EndgameRequestCallback")
+      .AddTraceSource("DuplicateData", "Reception of another copy of a piece requested in endgame mode",
+                      MakeTraceSourceAccessor(&NTorrentAdHocAppNaive::m_duplicateData),
+                      "ns3::ndn::NTorrentAdHocAppNaive::DuplicateDataCallback");
     return tid;
 }
 
@@ -90,11 +125,6 @@ NTorrentAdHocAppNaive::StartApplication()
     } else {
       ndn::FibHelper::AddRoute(GetNode(), "movie1", m_face, 0);
     }
-    // malloc to dynamically allocate the bitmap memory based on the
-    // number of torrent pieces
-    // The array will be initialized in PopulateBitmap
-    m_bitmap = (char*) malloc(sizeof(char) * m_torrentPacketNum);
-
     PopulateBitmap();
 
     m_random = CreateObject<UniformRandomVariable>();
@@ -108,16 +138,13 @@ NTorrentAdHocAppNaive::StartApplication()
 
     m_beaconSent = Simulator::Schedule(ns3::MilliSeconds(m_randomBeacon->GetValue() + 2000), &NTorrentAdHocAppNaive::SendBeacon, this);
 
-    m_expireTime = 200000000; // ns
+    m_overheard.SetLifetime(m_expireTime);
 }
 
 void
 NTorrentAdHocAppNaive::StopApplication()
 {
     App::StopApplication();
-
-    // delete the bitmap memory
-    delete(m_bitmap);
 }
 
 void
@@ -175,30 +202,19 @@ NTorrentAdHocAppNaive::OnInterest(shared_ptr<const Interest> interest)
       }
       // TODO: Check if the bitmap is for the desired torrent file
       // Decide what to do with received Interest
-      bool overheardInterest = false;
-      for (auto it = m_overheard.begin(); it != m_overheard.end(); it++) {
-        if (it->first == interestName.get(1).toUri()) {
-          NS_LOG_DEBUG("Interest Desires Other Torrent File (seen before): " << interestName.get(1).toUri());
-          if (it->second > Simulator::Now()) { // entry hasn't expired, refresh expire time
-            overheardInterest = true;
-            // Update Expire Time for torrent file if already in overheardInterest
-            it->second = Simulator::Now() + m_expireTime;
-            break;
-          } else { // only one entry per prefix in overheard at a time
-            m_overheard.erase(it);
-            break;
-          }
-        }
-      }
+      std::string prefix = getComponentValue(interestName.get(1));
+      bool overheardInterest = m_overheard.Refresh(prefix, Simulator::Now());
+      if (overheardInterest)
+        NS_LOG_DEBUG("Interest Desires Other Torrent File (seen before): " << prefix);
 
-      if ('/' + interestName.get(1).toUri() != m_torrentPrefix.toUri()) {
+      if (!IsTorrentPrefix(interestName.get(1))) {
         if (overheardInterest) {
           // std::string bitmap = DecodeBitmap(interest);
           Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::ForwardInterest, this, interest);
         } else { // Haven't overheard
           // Only input if torrent prefix does not match node's desired Torrent File
-          m_overheard.push_back(std::make_pair(interestName.get(1).toUri(), Simulator::Now() + m_expireTime));
-          NS_LOG_DEBUG("Time Entry Expires: " << m_overheard.back().second);
+          m_overheard.Insert(prefix, Simulator::Now());
+          NS_LOG_DEBUG("Time Entry Expires: " << Simulator::Now() + m_expireTime);
         }
 
         // Go back to sending beacons
@@ -207,42 +223,38 @@ NTorrentAdHocAppNaive::OnInterest(shared_ptr<const Interest> interest)
         }
       } else {
         // Decode the bitmap of the neighbor
-        std::string bitmap = DecodeBitmap(interest);
-        Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::CreateAndSendBitmap, this, interest);
-        if (!m_scarcity.empty())
-          Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendInterestForData, this, interestName.get(2).toUri(), bitmap);
+        const ::ndn::name::Component& bitmapNameComp = interestName.get(3);
+        BitmapAdvertisement advertisement;
+        if (advertisement.WireDecode(bitmapNameComp.value(), bitmapNameComp.value_size())) {
+          shared_ptr<const PieceBitmap> bitmap = DecodeBitmap(advertisement);
+          Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::CreateAndSendBitmap, this, interest, advertisement.sender);
+          if (bitmap != nullptr && !m_scarcity.IsEmpty())
+            Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendInterestForData, this, advertisement.sender, bitmap);
+        }
+        else {
+          NS_LOG_ERROR("Malformed bitmap advertisement: " << interestName.toUri());
+        }
       }
     }
     else {
       // TODO: Check if the Interest for torrent data is for the desired torrent file
       // Decide what to do with received Interest
-      bool overheardInterest = false;
-      for (auto it = m_overheard.begin(); it != m_overheard.end(); it++) {
-        if (it->first == interestName.get(0).toUri()) {
-          NS_LOG_DEBUG("Interest Desires Other Torrent File: " << interestName.get(0).toUri());
-          if (it->second > Simulator::Now()) {
-            overheardInterest = true;
-            // Update Expire Time for torrent file if already in overheardInterest
-            it->second = Simulator::Now() + m_expireTime;
-            break;
-          } else {
-            m_overheard.erase(it);
-            break;
-          }
-        }
-      }
+      std::string prefix = getComponentValue(interestName.get(0));
+      bool overheardInterest = m_overheard.Refresh(prefix, Simulator::Now());
+      if (overheardInterest)
+        NS_LOG_DEBUG("Interest Desires Other Torrent File: " << prefix);
 
-      if ('/' + interestName.get(0).toUri() != m_torrentPrefix.toUri()) {
+      if (!IsTorrentPrefix(interestName.get(0))) {
         // If overheard other nodes wanting this torrent prefix
         if (overheardInterest) {
           Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::ForwardInterest, this, interest);
         } else {
           // Only input if torrent prefix does not match node's desired Torrent File
-          m_overheard.push_back(std::make_pair(interestName.get(0).toUri(), Simulator::Now() + m_expireTime));
-          NS_LOG_DEBUG("Time Entry Expires: " << m_overheard.back().second << " for " << interestName.toUri());
+          m_overheard.Insert(prefix, Simulator::Now());
+          NS_LOG_DEBUG("Time Entry Expires: " << Simulator::Now() + m_expireTime << " for " << interestName.toUri());
         }
       // this is an Interest for torrent data
-      } else if (std::get<1>(m_downloadedData[interestName.get(-1).toSequenceNumber()]) == 1) {
+      } else if (m_bitmap.Test(interestName.get(-1).toSequenceNumber())) {
         Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendData, this, interestName);
       }
     }
@@ -262,27 +274,26 @@ NTorrentAdHocAppNaive::OnData(shared_ptr<const Data> data)
       Simulator::Cancel(m_bitmapSent);
     }
     NS_LOG_DEBUG("Received Bitmap in data packet: " << data->getName().toUri());
-    std::string bitmap = DecodeBitmap(data);
-
-    bool overheardInterest = false;
-    for (auto it = m_overheard.begin(); it != m_overheard.end(); it++) {
-        if (it->first == data->getName().get(1).toUri()) {
-            NS_LOG_DEBUG("Received Bitmap Data Wants Other File: " << data->getName().get(1).toUri());
-          if (it->second > Simulator::Now()) { // check if still not expired
-            overheardInterest = true;
-            // Update Expire Time for torrent file if already in overheardInterest
-            it->second = Simulator::Now() + m_expireTime;
-            break;
-          } else {
-            m_overheard.erase(it);
-            break;
-          }
-        }
-    }
+
+    std::string prefix = getComponentValue(data->getName().get(1));
+    bool overheardInterest = m_overheard.Refresh(prefix, Simulator::Now());
+    if (overheardInterest)
+      NS_LOG_DEBUG("Received Bitmap Data Wants Other File: " << prefix);
 
     // Request for torrent data if incoming bitmap shares same torrent file prefix
-    if (!m_scarcity.empty() && '/' + data->getName().get(1).toUri() == m_torrentPrefix.toUri()) {
-      Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendInterestForData, this, data->getName().get(2).toUri(), bitmap);
+    if (!m_scarcity.IsEmpty() && IsTorrentPrefix(data->getName().get(1))) {
+      // Decode the bitmap of the neighbor from the content. The name carries
+      // the id of the requester, the advertisement the id of the sender
+      const ::ndn::Block& contentBlock = data->getContent();
+      BitmapAdvertisement advertisement;
+      if (advertisement.WireDecode(contentBlock.value(), contentBlock.value_size())) {
+        shared_ptr<const PieceBitmap> bitmap = DecodeBitmap(advertisement);
+        if (bitmap != nullptr)
+          Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendInterestForData, this, advertisement.sender, bitmap);
+      }
+      else {
+        NS_LOG_ERROR("Malformed bitmap advertisement: " << data->getName().toUri());
+      }
     } else {
       if (overheardInterest) {
         // Forward since already heard bitmap interest for that torrent file
@@ -297,49 +308,67 @@ NTorrentAdHocAppNaive::OnData(shared_ptr<const Data> data)
   else {
     // Logic for receiving a data packet
     NS_LOG_DEBUG("Received torrent data: " << data->getName().toUri());
-    if (m_scarcity.empty() || '/' + data->getName().get(0).toUri() != m_torrentPrefix.toUri()) {
-      // if we have downloaded all the torrent data or not the corrent torrent file
-      // avoid doing all the rest
+    if (!IsTorrentPrefix(data->getName().get(0))) {
+      // if this is not the corrent torrent file avoid doing all the rest
+      return;
+    }
+    uint32_t seqNum = data->getName().get(-1).toSequenceNumber();
+    if (seqNum >= m_torrentPacketNum) {
+      NS_LOG_ERROR("Torrent data out of range: " << data->getName().toUri());
       return;
     }
-    if (std::get<1>(m_downloadedData[data->getName().get(-1).toSequenceNumber()]) == 0) {
-      m_downloadedData[data->getName().get(-1).toSequenceNumber()].second = 1;
+    if (m_bitmap.Test(seqNum)) {
+      // another copy of the piece has already arrived, or we have downloaded
+      // all the torrent data. Only the copies of pieces requested again in
+      // endgame mode are the overhead of the endgame
+      NS_LOG_DEBUG("Duplicate torrent data: " << data->getName().toUri());
+      if (m_endgamePieces.Test(seqNum))
+        m_duplicateData(seqNum);
+      return;
     }
+
     // cancel retransmission, erase scarcity entry
-    std::string nodeId;
-    std::string bitmap = "\0";
-    for (auto it = m_outstandingInterests.begin(); it != m_outstandingInterests.end(); it++) {
-      if (data->getName().get(-1).toSequenceNumber() == std::get<0>(*it)) {
-        nodeId = std::get<1>(*it);
-        bitmap = std::get<2>(*it);
-        Simulator::Cancel(std::get<3>(*it));
-
-        m_outstandingInterests.erase(it);
-        break;
-      }
+    OutstandingInterest outstanding = m_outstandingInterests[seqNum];
+    m_outstandingInterests[seqNum] = OutstandingInterest();
+    if (outstanding.isPending) {
+      Simulator::Cancel(outstanding.retransmission);
+      if (outstanding.retransmissions == 0)
+        UpdateRtt(outstanding.nodeId, Simulator::Now() - outstanding.sentTime);
     }
 
     // erase scarcity entry
-    for (auto it = m_scarcity.begin(); it != m_scarcity.end(); it++) {
-      if (it->first == data->getName().get(-1).toSequenceNumber()) {
-        m_scarcity.erase(it);
-        break;
-      }
-    }
+    m_scarcity.Erase(seqNum);
 
-    if (m_scarcity.empty()) {
+    if (m_scarcity.IsEmpty()) {
       // we just finished downloading all the data
       m_downloadedAllData = true;
       // NS_LOG_DEBUG("Finished downloading torrent data: " << Simulator::Now().GetMilliSeconds() / 1000.0 << " sec");
       std::cerr << "Finished downloading torrent data: " << Simulator::Now().GetMilliSeconds() / 1000.0 << " sec" << std::endl;
     }
 
-    // update your own bitmap
-    m_bitmap[data->getName().get(-1).toSequenceNumber()] = 1;
+    // update your own bitmap, a new piece makes a new version
+    m_bitmap.Set(seqNum);
+    m_gainLog.push_back(seqNum);
+
+    // Open the window of the node and refill it right away, using the
+    // latest bitmap of the node
+    if (outstanding.isPending) {
+      NeighborState& neighbor = m_neighbors[outstanding.nodeId];
+      neighbor.inFlight--;
+      neighbor.window = std::min<double>(neighbor.window + 1.0 / neighbor.window, m_maxWindow);
+      if (neighbor.bitmap != nullptr)
+        outstanding.bitmap = neighbor.bitmap;
+      if (!m_scarcity.IsEmpty())
+        Simulator::ScheduleNow(&NTorrentAdHocAppNaive::SendInterestForData, this, outstanding.nodeId, outstanding.bitmap);
+    }
 
-    // Send next Interest for data
-    if (bitmap != "\0")
-      Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocAppNaive::SendInterestForData, this, nodeId, bitmap);
+    // the other copies requested in endgame mode are not waited for anymore
+    for (uint32_t nodeId : outstanding.endgameNodes) {
+      NeighborState& neighbor = m_neighbors[nodeId];
+      neighbor.inFlight--;
+      if (!m_scarcity.IsEmpty() && neighbor.bitmap != nullptr)
+        Simulator::ScheduleNow(&NTorrentAdHocAppNaive::SendInterestForData, this, nodeId, neighbor.bitmap);
+    }
   }
 }
 
@@ -355,7 +384,9 @@ NTorrentAdHocAppNaive::SendBitmap(uint32_t retransmissions)
   }
   // Send a bitmap
   Name beaconName = Name("bitmap" + m_torrentPrefix.toUri() + "/node" + std::to_string(m_nodeId));
-  beaconName.append((uint8_t*) m_bitmap, m_torrentPacketNum);
+  std::vector<uint8_t> wire;
+  EncodeAdvertisement(GetBroadcastBase(), wire);
+  beaconName.append(wire.data(), wire.size());
   beaconName.appendSequenceNumber(m_seq);
   m_seq++;
   NS_LOG_DEBUG("Sending bitmap, time " << retransmissions + 1 << " name: " << beaconName.toUri());
@@ -372,32 +403,35 @@ void
 NTorrentAdHocAppNaive::PopulateBitmap()
 {
   NS_LOG_DEBUG("Populate Bitmap with data");
-  // loop through all the data packets of the torrent
+  m_bitmap.Resize(m_torrentPacketNum);
+  m_endgamePieces.Resize(m_torrentPacketNum);
+  m_scarcity.Reset(m_torrentPacketNum);
+  m_outstandingInterests.assign(m_torrentPacketNum, OutstandingInterest());
+  if (m_isTorrentProducer) {
+    // if this is the original torrent producer, it has all the data packets
+    m_bitmap.SetAll();
+    return;
+  }
+  // if this is not the original producer, it does not have data initially
   for (auto i = 0; i < m_torrentPacketNum; i++) {
-    // create something like a bitmap for each data packet that I have
-    // each character (1-byte) will be either 1 if I have the data packet,
-    // or 0 if I do not
-    if (m_isTorrentProducer) {
-      // if this is the original torrent producer
-      m_bitmap[i] = 1;
-      m_downloadedData.push_back(std::make_pair(i, 1));
-    }
-    else {
-      // if this is not the original producer, it does not have data initially
-      m_bitmap[i] = 0;
-      m_scarcity.push_back(std::make_pair(i, 1));
-      m_downloadedData.push_back(std::make_pair(i, 0));
-    }
+    m_scarcity.Insert(i);
   }
 }
 
 void
-NTorrentAdHocAppNaive::CreateAndSendBitmap(shared_ptr<const Interest> interest)
+NTorrentAdHocAppNaive::CreateAndSendBitmap(shared_ptr<const Interest> interest, uint32_t requester)
 {
   shared_ptr<Data> data = make_shared<Data>(interest->getName());
 
   data->setContentType(::ndn::tlv::ContentType_Blob);
-  data->setContent((uint8_t*) m_bitmap, m_torrentPacketNum);
+  // the requester has just told us which version of our bitmap it knows
+  uint32_t base = 0;
+  auto neighbor = m_neighbors.find(requester);
+  if (neighbor != m_neighbors.end())
+    base = neighbor->second.ackedVersion;
+  std::vector<uint8_t> wire;
+  EncodeAdvertisement(base, wire);
+  data->setContent(wire.data(), wire.size());
 
   Signature signature;
   SignatureInfo signatureInfo(static_cast< ::ndn::tlv::SignatureTypeValue>(255));
@@ -417,107 +451,198 @@ NTorrentAdHocAppNaive::CreateAndSendBitmap(shared_ptr<const Interest> interest)
 
 }
 
-std::string
-NTorrentAdHocAppNaive::DecodeBitmap(shared_ptr<const Data> data)
+void
+NTorrentAdHocAppNaive::EncodeAdvertisement(uint32_t base, std::vector<uint8_t>& wire) const
 {
-  // First, decode the received bitmap
-  std::string bitmap;
-  ::ndn::Block contentBlock = data->getContent();
-  for (auto it = contentBlock.value_begin(); it != contentBlock.value_end(); it++) {
-    bitmap.append(std::to_string(*it));
+  BitmapAdvertisement advertisement;
+  advertisement.sender = m_nodeId;
+  advertisement.version = GetBitmapVersion();
+  // acknowledge the bitmap version of every live neighbor
+  for (const auto& neighbor : m_neighbors) {
+    if (neighbor.second.knownVersion != 0 &&
+        neighbor.second.lastHeard + m_neighborTimeout > Simulator::Now())
+      advertisement.acks.emplace_back(neighbor.first, neighbor.second.knownVersion);
   }
 
-  // Then, update the local piece scarcity knowledge
-  // search for all the pieces the peer does not have in the received
-  // bitmap, and add 1 to the piece counter if the peer that sent the bitmap
-  // does not have the piece as well
-  for (auto i = 0; i < m_torrentPacketNum; i++) {
-    if (m_downloadedData[i].second == 0) {
-      if (bitmap[i] == 0) {
-        for (auto it = m_scarcity.begin(); it != m_scarcity.end(); it++) {
-          if (it->first == i)
-            it->second = it->second + 1;
-        }
-      }
-    }
+  // send only the pieces gained since base, unless this is not smaller
+  // than the raw bitmap
+  if (base != 0 && base <= advertisement.version) {
+    advertisement.base = base;
+    advertisement.WireEncodeDelta(m_gainLog.data() + base - 1, advertisement.version - base, wire);
+    if (wire.size() < m_bitmap.GetWireSize())
+      return;
+  }
+  advertisement.base = 0;
+  advertisement.WireEncodeFull(m_bitmap, wire);
+}
+
+uint32_t
+NTorrentAdHocAppNaive::GetBroadcastBase() const
+{
+  // a broadcast advertisement has to be understood by every live neighbor,
+  // so it is a delta from the oldest version they have acknowledged
+  uint32_t base = 0;
+  bool hasLiveNeighbor = false;
+  for (const auto& neighbor : m_neighbors) {
+    if (neighbor.second.lastHeard + m_neighborTimeout <= Simulator::Now())
+      continue;
+    uint32_t acked = neighbor.second.ackedVersion;
+    if (acked == 0 || acked > GetBitmapVersion())
+      return 0;
+    base = hasLiveNeighbor ? std::min(base, acked) : acked;
+    hasLiveNeighbor = true;
   }
-  return (std::string(bitmap));
+  return base;
 }
 
-std::string
-NTorrentAdHocAppNaive::DecodeBitmap(shared_ptr<const Interest> interest)
+shared_ptr<const PieceBitmap>
+NTorrentAdHocAppNaive::DecodeBitmap(const BitmapAdvertisement& advertisement)
 {
-  // First, decode the received bitmap
-  char bitmap[m_torrentPacketNum];
-  std::string bitmapNameComp = interest->getName().get(3).toUri();
-  int j = 0;
-  for (auto i = 0; i < m_torrentPacketNum * 3; i = i + 3) {
-    bitmap[j] = (bitmapNameComp[i + 1] << 4) | (bitmapNameComp[i + 2]);
-    // std::cout << "Element " << j << " is " << bitmap[j] << std::endl;
-    j++;
+  if (advertisement.sender == m_nodeId)
+    return nullptr;
+
+  NeighborState& neighbor = m_neighbors[advertisement.sender];
+  neighbor.lastHeard = Simulator::Now();
+  // the neighbor tells us which version of our bitmap it knows. If it does
+  // not know any, our next advertisement will carry the full bitmap
+  neighbor.ackedVersion = advertisement.GetAck(m_nodeId);
+
+  bool isDelta = (advertisement.base != 0);
+  if (isDelta && (neighbor.bitmap == nullptr || advertisement.base > neighbor.knownVersion)) {
+    NS_LOG_DEBUG("Cannot apply bitmap delta from version " << advertisement.base << " of node "
+                 << advertisement.sender << ", known version " << neighbor.knownVersion);
+    return nullptr;
   }
 
+  // First, decode the received bitmap. Reuse the previous bitmap of the
+  // neighbor if no outstanding Interest or scheduled event refers to it
+  shared_ptr<PieceBitmap> bitmap;
+  if (neighbor.bitmap != nullptr && neighbor.bitmap.use_count() == 1)
+    bitmap = neighbor.bitmap;
+  else if (isDelta)
+    bitmap = make_shared<PieceBitmap>(*neighbor.bitmap);
+  else
+    bitmap = make_shared<PieceBitmap>(m_torrentPacketNum);
+
+  if (!advertisement.Apply(*bitmap)) {
+    NS_LOG_ERROR("Malformed bitmap from node: " << advertisement.sender);
+    // a reused bitmap has been partially overwritten
+    if (neighbor.bitmap == bitmap) {
+      neighbor.bitmap = nullptr;
+      neighbor.knownVersion = 0;
+      m_scarcity.EraseNeighbor(advertisement.sender);
+    }
+    return nullptr;
+  }
+  neighbor.bitmap = bitmap;
+  // an older delta adds nothing new, the bitmap stays at the known version
+  if (isDelta)
+    neighbor.knownVersion = std::max(neighbor.knownVersion, advertisement.version);
+  else
+    neighbor.knownVersion = advertisement.version;
+
   // Then, update the local piece scarcity knowledge
+  UpdateScarcity(*bitmap);
+  m_scarcity.UpdateNeighbor(advertisement.sender, *bitmap);
+  return bitmap;
+}
+
+void
+NTorrentAdHocAppNaive::UpdateScarcity(const PieceBitmap& bitmap)
+{
   // search for all the pieces the peer does not have in the received
   // bitmap, and add 1 to the piece counter if the peer that sent the bitmap
-  // does not have the piece as well
-  for (auto i = 0; i < m_torrentPacketNum; i++) {
-    if (m_downloadedData[i].second == 0) {
-      if (bitmap[i] == 0) {
-        for (auto it = m_scarcity.begin(); it != m_scarcity.end(); it++) {
-          if (it->first == i)
-            it->second = it->second + 1;
-        }
-      }
-    }
-  }
-  return (std::string(bitmap));
+  // does not have the piece as well. The counters are updated in a batch,
+  // so that the neighbor trees are refreshed at most once
+  std::vector<uint32_t> missing;
+  bitmap.ForEachMissingInBoth(m_bitmap, [&missing] (uint32_t seq) {
+      missing.push_back(seq);
+    });
+  m_scarcity.IncrementAll(missing);
 }
 
 void
-NTorrentAdHocAppNaive::SendInterestForData(std::string nodeId, std::string bitmap)
+NTorrentAdHocAppNaive::SendInterestForData(uint32_t nodeId, shared_ptr<const PieceBitmap> bitmap)
 {
-  // sort the scarcity list
-  m_scarcity.sort(compare_pairs);
-  uint32_t seqNum = -1;
-  // find the rarest piece that the other peer has and there is
-  // no outstanding Interest
-  for (auto it = m_scarcity.begin(); it != m_scarcity.end(); it++) {
-    if (bitmap[std::get<0>(*it)] == '1') {
-      // check if we have already sent an outstanding Interest
-      bool outstadingInterestFound = false;
-      for (auto it2 = m_outstandingInterests.begin(); it2 != m_outstandingInterests.end(); it2++) {
-        if (std::get<0>(*it2) == std::get<0>(*it)) {
-          outstadingInterestFound = true;
-          break;
-        }
-      }
-      if (outstadingInterestFound) {
-        continue;
-      }
-      seqNum = std::get<0>(*it);
-      break;
+  NeighborState& neighbor = m_neighbors[nodeId];
+  if (neighbor.window == 0)
+    neighbor.window = std::min(m_initialWindow, m_maxWindow);
+  if (neighbor.rto.IsZero())
+    neighbor.rto = m_expirationTimer;
+
+  // Skip the scarcity walk when a few word operations show the other peer
+  // has nothing we miss
+  bool hasMissingPiece = bitmap->FindFirstMissing(m_bitmap) != PieceBitmap::NO_PIECE;
+
+  bool isEndgame = m_scarcity.GetSize() <= m_endgameThreshold;
+
+  uint32_t nSent = 0;
+  while (hasMissingPiece && neighbor.inFlight < static_cast<uint32_t>(neighbor.window)) {
+    // find the rarest piece that the other peer has and there is
+    // no outstanding Interest
+    uint32_t seqNum = m_scarcity.FindRarestFrom(nodeId);
+
+    if (seqNum == PieceScarcity::NO_PIECE && isEndgame) {
+      // in endgame mode, request again the rarest piece that is outstanding
+      // with other nodes only. The first copy to arrive ends all the requests.
+      // At most m_endgameThreshold pieces are left, so they are just walked
+      seqNum = m_scarcity.FindRarest([this, &bitmap, nodeId] (uint32_t seq) {
+        const OutstandingInterest& outstanding = m_outstandingInterests[seq];
+        return bitmap->Test(seq) && outstanding.isPending && outstanding.nodeId != nodeId &&
+               std::find(outstanding.endgameNodes.begin(), outstanding.endgameNodes.end(), nodeId) == outstanding.endgameNodes.end();
+      });
+      if (seqNum == PieceScarcity::NO_PIECE)
+        break;
+
+      // The name does not address the node: the Interest, with a fresh Nonce,
+      // is broadcast again and NFD forwards it as a retransmission of the
+      // pending Interest, which any neighbor that has the piece may answer.
+      // The node lends a window slot, given back when the piece arrives
+      Name interestName = Name(m_torrentPrefix).appendSequenceNumber(seqNum);
+      shared_ptr<Interest> interest = make_shared<Interest>(interestName);
+      NS_LOG_INFO("Sending endgame Interest for Torrent Data Packet: " << interestName.toUri());
+
+      m_endgamePieces.Set(seqNum);
+      m_outstandingInterests[seqNum].endgameNodes.push_back(nodeId);
+      neighbor.inFlight++;
+      nSent++;
+      m_endgameRequest(nodeId, seqNum);
+
+      m_transmittedInterests(interest, this, m_face);
+      m_appLink->onReceiveInterest(*interest);
+      continue;
     }
+    if (seqNum == PieceScarcity::NO_PIECE)
+      break;
+
+    // create the Interest
+    Name interestName = Name(m_torrentPrefix).appendSequenceNumber(seqNum);
+    shared_ptr<Interest> interest = make_shared<Interest>(interestName);
+    NS_LOG_INFO("Sending Interest for Torrent Data Packet: " << interestName.toUri());
+
+    // schedule the Interest retansmission event
+    ns3::EventId retransmission = Simulator::Schedule(neighbor.rto, &NTorrentAdHocAppNaive::ResendInterestForData, this, interestName, 0);
+
+    OutstandingInterest& outstanding = m_outstandingInterests[seqNum];
+    outstanding.isPending = true;
+    outstanding.nodeId = nodeId;
+    outstanding.bitmap = bitmap;
+    outstanding.retransmission = retransmission;
+    outstanding.sentTime = Simulator::Now();
+    outstanding.retransmissions = 0;
+    m_scarcity.SetPending(seqNum, true);
+    neighbor.inFlight++;
+    nSent++;
+
+    m_transmittedInterests(interest, this, m_face);
+    m_appLink->onReceiveInterest(*interest);
   }
-  if (seqNum == -1) {
+
+  if (nSent == 0 && neighbor.inFlight == 0) {
     NS_LOG_INFO("Could not find a missing piece to fetch from: " << nodeId);
     if (!m_beaconSent.IsRunning())
       m_beaconSent = Simulator::Schedule(ns3::MilliSeconds(m_randomBeacon->GetValue() + 2000), &NTorrentAdHocAppNaive::SendBeacon, this);
-    return;
   }
-
-  // create the Interest
-  Name interestName = Name(m_torrentPrefix).appendSequenceNumber(seqNum);
-  shared_ptr<Interest> interest = make_shared<Interest>(interestName);
-  NS_LOG_INFO("Sending Interest for Torrent Data Packet: " << interestName.toUri());
-
-  // schedule the Interest retansmission event
-  ns3::EventId retransmission = Simulator::Schedule(m_expirationTimer, &NTorrentAdHocAppNaive::ResendInterestForData, this, interestName, 0);
-
-  m_outstandingInterests.push_back(std::make_tuple(seqNum, nodeId, bitmap, retransmission));
-
-  m_transmittedInterests(interest, this, m_face);
-  m_appLink->onReceiveInterest(*interest);
 }
 
 void
@@ -564,37 +689,70 @@ NTorrentAdHocAppNaive::SendBeacon()
 }
 
 void
-NTorrentAdHocAppNaive::ResendInterestForData(Name interestName, uint8_t numberOfRetransmissions)
+NTorrentAdHocAppNaive::UpdateRtt(uint32_t nodeId, Time rtt)
+{
+  NeighborState& neighbor = m_neighbors[nodeId];
+  int64_t r = rtt.GetNanoSeconds();
+  if (!neighbor.hasRttSample) {
+    neighbor.srtt = rtt;
+    neighbor.rttvar = NanoSeconds(r / 2);
+    neighbor.hasRttSample = true;
+  }
+  else {
+    // rttvar = 3/4 rttvar + 1/4 |srtt - r|, srtt = 7/8 srtt + 1/8 r
+    int64_t srtt = neighbor.srtt.GetNanoSeconds();
+    int64_t delta = srtt > r ? srtt - r : r - srtt;
+    neighbor.rttvar = NanoSeconds((3 * neighbor.rttvar.GetNanoSeconds() + delta) / 4);
+    neighbor.srtt = NanoSeconds((7 * srtt + r) / 8);
+  }
+  // a new sample also ends any backoff
+  Time rto = neighbor.srtt + NanoSeconds(4 * neighbor.rttvar.GetNanoSeconds());
+  neighbor.rto = std::min(std::max(rto, m_minRto), m_maxRto);
+
+  m_rttEstimate(nodeId, rtt, neighbor.srtt, neighbor.rttvar, neighbor.rto);
+}
+
+void
+NTorrentAdHocAppNaive::ResendInterestForData(Name interestName, uint32_t numberOfRetransmissions)
 {
   uint32_t seqNum = interestName.get(-1).toSequenceNumber();
-  if (numberOfRetransmissions == 3) {
-    // if we have done already 3 retransmissions, then just erase outstanding
+  OutstandingInterest& outstanding = m_outstandingInterests[seqNum];
+  NeighborState& neighbor = m_neighbors[outstanding.nodeId];
+
+  // the Interest timeout doubles with every retransmission
+  Time rto = neighbor.rto;
+  for (uint32_t i = 0; i < numberOfRetransmissions && rto < m_maxRto; i++) {
+    rto = rto + rto;
+  }
+  rto = std::min(rto, m_maxRto);
+  Time backoff = std::min(rto + rto, m_maxRto);
+  m_interestTimeout(outstanding.nodeId, seqNum, numberOfRetransmissions, backoff);
+
+  if (numberOfRetransmissions >= m_maxRetransmissions) {
+    // if we have done already all the retransmissions, then just erase outstanding
     // Interest entry and schedule the next beacon trasmission
     NS_LOG_INFO("Reached maximum number of retransmissions for: " << interestName.toUri());
-    for (auto it = m_outstandingInterests.begin(); it != m_outstandingInterests.end(); it++) {
-      if (seqNum == std::get<0>(*it)) {
-        m_outstandingInterests.erase(it);
-        break;
-      }
+    neighbor.inFlight--;
+    for (uint32_t nodeId : outstanding.endgameNodes) {
+      m_neighbors[nodeId].inFlight--;
     }
+    outstanding = OutstandingInterest();
+    m_scarcity.SetPending(seqNum, false);
     if (!m_beaconSent.IsRunning())
       m_beaconSent = Simulator::Schedule(ns3::MilliSeconds(m_randomBeacon->GetValue() + 2000), &NTorrentAdHocAppNaive::SendBeacon, this);
     return;
   }
 
-  // if we have not done 3 retransmissions, retransmit
+  // a timeout closes the window of the node
+  neighbor.window = std::max(neighbor.window / 2, 1.0);
+
+  // if we have not done all the retransmissions, retransmit
   shared_ptr<Interest> interest = make_shared<Interest>(interestName);
   NS_LOG_INFO("Retransmitting Interest for Torrent Data Packet: " << interestName.toUri());
 
-  // schedule the Interest retansmission event
-  ns3::EventId retransmission = Simulator::Schedule(m_expirationTimer, &NTorrentAdHocAppNaive::ResendInterestForData, this, interestName, numberOfRetransmissions + 1);
-
-  for (auto it = m_outstandingInterests.begin(); it != m_outstandingInterests.end(); it++) {
-    if (seqNum == std::get<0>(*it)) {
-      std::get<3>(*it) = retransmission;
-      break;
-    }
-  }
+  // schedule the Interest retansmission event, backing off the timeout
+  outstanding.retransmission = Simulator::Schedule(backoff, &NTorrentAdHocAppNaive::ResendInterestForData, this, interestName, numberOfRetransmissions + 1);
+  outstanding.retransmissions = numberOfRetransmissions + 1;
 
   m_transmittedInterests(interest, this, m_face);
   m_appLink->onReceiveInterest(*interest);
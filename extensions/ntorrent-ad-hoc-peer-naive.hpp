@@ -38,6 +38,11 @@
 #include "NFD/rib/rib-manager.hpp"
 #include "ns3/ndnSIM/helper/ndn-strategy-choice-helper.hpp"
 
+#include "ntorrent-bitmap-advertisement.hpp"
+#include "ntorrent-overheard-table.hpp"
+#include "ntorrent-piece-bitmap.hpp"
+#include "ntorrent-piece-scarcity.hpp"
+
 #include <tuple>
 #include <unordered_map>
 
@@ -55,6 +60,14 @@ public:
   NTorrentAdHocAppNaive();
   ~NTorrentAdHocAppNaive();
 
+  typedef void (*RttEstimateCallback)(uint32_t nodeId, Time rtt, Time srtt, Time rttvar, Time rto);
+
+  typedef void (*InterestTimeoutCallback)(uint32_t nodeId, uint32_t seqNum, uint32_t retransmissions, Time rto);
+
+  typedef void (*EndgameRequestCallback)(uint32_t nodeId, uint32_t seqNum);
+
+  typedef void (*DuplicateDataCallback)(uint32_t seqNum);
+
   virtual void
   StartApplication();
 
@@ -87,25 +100,69 @@ private:
   PopulateBitmap();
 
   void
-  CreateAndSendBitmap(shared_ptr<const Interest> interest);
+  CreateAndSendBitmap(shared_ptr<const Interest> interest, uint32_t requester);
 
-  std::string
-  DecodeBitmap(shared_ptr<const Data> data);
-
-  std::string
-  DecodeBitmap(shared_ptr<const Interest> interest);
+  /**
+   * @brief encode our bitmap advertisement, as a delta from version base if
+   * base is not 0 and the delta is smaller than the full bitmap
+   */
+  void
+  EncodeAdvertisement(uint32_t base, std::vector<uint8_t>& wire) const;
+
+  /**
+   * @brief version of our bitmap that every live neighbor has acknowledged,
+   * or 0 if some live neighbor needs the full bitmap
+   */
+  uint32_t
+  GetBroadcastBase() const;
+
+  uint32_t
+  GetBitmapVersion() const
+  {
+    return m_gainLog.size() + 1;
+  }
+
+  /**
+   * @brief apply the bitmap advertisement of a neighbor, decoded straight
+   * from the bytes of the bitmap name component or of the bitmap Data
+   * content, and update the local piece scarcity knowledge
+   * @return the bitmap of the neighbor, or nullptr if the advertisement is
+   *         malformed or is a delta from a version we do not know
+   */
+  shared_ptr<const PieceBitmap>
+  DecodeBitmap(const BitmapAdvertisement& advertisement);
 
   void
-  SendInterestForData(std::string nodeId, std::string bitmap);
+  UpdateScarcity(const PieceBitmap& bitmap);
+
+  bool
+  IsTorrentPrefix(const ::ndn::name::Component& component) const
+  {
+    return m_torrentPrefix.size() == 1 && m_torrentPrefix.get(0) == component;
+  }
+
+  /**
+   * @brief fill the window of the neighbor with Interests for the rarest
+   * pieces it has and we are missing
+   */
+  void
+  SendInterestForData(uint32_t nodeId, shared_ptr<const PieceBitmap> bitmap);
 
   void
   SendData(Name interestName);
 
+  /**
+   * @brief feed an RTT sample of the node to its estimator and recompute its
+   * retransmission timeout (RFC 6298)
+   */
+  void
+  UpdateRtt(uint32_t nodeId, Time rtt);
+
   void
   SendBeacon();
 
   void
-  ResendInterestForData(Name interestName, uint8_t numberOfRetransmissions);
+  ResendInterestForData(Name interestName, uint32_t numberOfRetransmissions);
 
 private:
   uint32_t m_torrentPacketNum;
@@ -114,11 +171,24 @@ private:
   bool m_isTorrentProducer;
   bool m_isPureForwarder;
   uint32_t m_nodeId;
-  int64x64_t m_expireTime;
+  Time m_expireTime;
 
   Time m_beaconTimer;
   Time m_randomTimerRange;
+  // initial retransmission timeout, before the first RTT sample
   Time m_expirationTimer;
+  Time m_minRto;
+  Time m_maxRto;
+  uint32_t m_maxRetransmissions;
+  Time m_neighborTimeout;
+
+  // window of outstanding piece Interests per neighbor
+  uint32_t m_initialWindow;
+  uint32_t m_maxWindow;
+
+  // below this number of missing pieces, pieces already requested from a
+  // neighbor are requested from the other neighbors that have them as well
+  uint32_t m_endgameThreshold;
 
   Ptr<RandomVariableStream> m_random;
   Ptr<RandomVariableStream> m_randomBeacon;
@@ -129,27 +199,89 @@ private:
   // sequence number for beacons
   uint64_t m_beaconSeq;
 
-  // Piece scarcity data structure. It contains pairs of
-  // <torrent packet sequence number, counter>
-  std::list<std::pair<uint32_t, uint32_t>> m_scarcity;
-
-  // bitmap structure (array of chars with value 1 if the peer has a packet,
-  // 0 if the peer does not)
-  char* m_bitmap;
-
-  // Structure for the data a node has. It contains pairs of
-  // <data packet seq number, value that indicates whether the nodes has this data packet>
-  // 1 if the node has this data packet, 0 if it does not
-  std::vector<std::pair<uint32_t, uint32_t>> m_downloadedData;
-
-  // outstanding Interests (data packets for which an Interest has been sent, but a
-  // data packet has not been received yet
-  // tuple of <seq number, nodeid, bitmap, Interest sending event>
-  std::vector<std::tuple<uint32_t, std::string, std::string, ns3::EventId>> m_outstandingInterests;
-
-  // overheard Torrent file names and time it stays in vector that want them
-  // std::vector<std::tuple<std:string, int64x64_t>> m_overheard;
-  std::vector<std::pair<std::string, int64x64_t>> m_overheard;
+  // Piece scarcity index. It tracks the missing pieces with a counter
+  // of peers that miss them as well, and indexes the pieces of every
+  // neighbor by that counter
+  PieceScarcity m_scarcity;
+
+  // bitmap structure (bit set if the peer has a packet, clear if the peer
+  // does not). This is also the structure for the data the node has
+  PieceBitmap m_bitmap;
+
+  // pieces in the order they were received. The version of the bitmap is
+  // the number of received pieces plus one, and m_gainLog[v - 1] is the
+  // piece received when going from version v to v + 1
+  std::vector<uint32_t> m_gainLog;
+
+  // pieces requested again in endgame mode
+  PieceBitmap m_endgamePieces;
+
+  // outstanding Interest for a data packet (an Interest has been sent, but a
+  // data packet has not been received yet)
+  struct OutstandingInterest
+  {
+    OutstandingInterest()
+      : isPending(false)
+      , nodeId(0)
+      , retransmissions(0)
+    {
+    }
+
+    bool isPending;
+    uint32_t nodeId;
+    // snapshot of the bitmap of the node the data packet is fetched from
+    shared_ptr<const PieceBitmap> bitmap;
+    ns3::EventId retransmission;
+    // time of the first transmission. Retransmitted Interests give no RTT
+    // sample, as the Data may answer any of the transmissions
+    Time sentTime;
+    uint32_t retransmissions;
+    // other nodes on whose window the Interest has been broadcast again in
+    // endgame mode. Their window slots are held as long as the request to
+    // nodeId
+    std::vector<uint32_t> endgameNodes;
+  };
+
+  // outstanding Interests indexed by data packet seq number
+  std::vector<OutstandingInterest> m_outstandingInterests;
+
+  struct NeighborState
+  {
+    NeighborState()
+      : knownVersion(0)
+      , ackedVersion(0)
+      , window(0)
+      , inFlight(0)
+      , hasRttSample(false)
+    {
+    }
+
+    // latest bitmap of the neighbor, at version knownVersion. Outstanding
+    // Interests share this bitmap, so it is only decoded over again when
+    // nothing else refers to it
+    shared_ptr<PieceBitmap> bitmap;
+    uint32_t knownVersion;
+    // latest version of our bitmap the neighbor has acknowledged
+    uint32_t ackedVersion;
+    Time lastHeard;
+    // number of piece Interests that may be outstanding for pieces of this
+    // neighbor (grows by one per window of received pieces, halves on
+    // timeout), and number of those currently outstanding
+    double window;
+    uint32_t inFlight;
+    // RTT estimator of the pieces fetched from this neighbor
+    bool hasRttSample;
+    Time srtt;
+    Time rttvar;
+    Time rto;
+  };
+
+  // neighbors that have advertised a bitmap for our torrent <nodeid, state>
+  std::unordered_map<uint32_t, NeighborState> m_neighbors;
+
+  // overheard Torrent file names that other nodes want, expiring
+  // m_expireTime after they were last heard
+  OverheardTable m_overheard;
 
   ns3::EventId m_beaconSent;
 
@@ -157,6 +289,14 @@ private:
 
   // has this peer downloaded all the data
   bool m_downloadedAllData;
+
+  TracedCallback<uint32_t, Time, Time, Time, Time> m_rttEstimate;
+
+  TracedCallback<uint32_t, uint32_t, uint32_t, Time> m_interestTimeout;
+
+  TracedCallback<uint32_t, uint32_t> m_endgameRequest;
+
+  TracedCallback<uint32_t> m_duplicateData;
 };
 
 } // namespace ndn
@@ -43,12 +43,20 @@ NTorrentAdHocApp::GetTypeId(void)
       // Node id
       .AddAttribute("NodeId", "Id of the current node", IntegerValue(-1),
                     MakeIntegerAccessor(&NTorrentAdHocApp::m_nodeId), MakeIntegerChecker<int32_t>())
+      // Smallest number of IBF cells. The IBF sent to a peer is sized to about twice the
+      // estimated number of differing pieces, doubling the size from IbfCells onwards
+      .AddAttribute("IbfCells", "Minimum number of cells of the IBF", IntegerValue(12),
+                    MakeIntegerAccessor(&NTorrentAdHocApp::m_ibfCells), MakeIntegerChecker<uint32_t>(1))
       // Send a new beacon every BeaconTimer seconds + random timer between 0 and RandomTimerRange
       .AddAttribute("BeaconTimer", "Periodic timer for beacons", StringValue("1s"),
                     MakeTimeAccessor(&NTorrentAdHocApp::m_beaconTimer), MakeTimeChecker())
       // Random timer between 0 and RandomTimerRange
       .AddAttribute("RandomTimerRange", "Random Timer Range", StringValue("1s"),
                     MakeTimeAccessor(&NTorrentAdHocApp::m_randomTimerRange), MakeTimeChecker())
+      // The number of peers known to hold a piece halves every AvailabilityHalfLife, so that
+      // the rarest-first choice follows the pieces spreading through the swarm
+      .AddAttribute("AvailabilityHalfLife", "Half-life of the piece availability estimates", StringValue("10s"),
+                    MakeTimeAccessor(&NTorrentAdHocApp::m_availabilityHalfLife), MakeTimeChecker())
       // Is this node the original torrent producer or just a peer?
       .AddAttribute("TorrentProducer", "Has this node generated the torrent?", BooleanValue(false),
                     MakeBooleanAccessor(&NTorrentAdHocApp::m_isTorrentProducer), MakeBooleanChecker());
@@ -59,7 +67,6 @@ NTorrentAdHocApp::NTorrentAdHocApp()
 {
   NS_ASSERT(m_nodeId != -1);
   m_seq = 0;
-  m_IBFhasChanged = true;
 }
 
 NTorrentAdHocApp::~NTorrentAdHocApp()
@@ -74,6 +81,7 @@ NTorrentAdHocApp::StartApplication()
     ndn::FibHelper::AddRoute(GetNode(), m_torrentPrefix, m_face, 0);
     ndn::FibHelper::AddRoute(GetNode(), "beacon", m_face, 0);
 
+    m_availability.SetHalfLife(m_availabilityHalfLife);
     PopulateIBF();
 
     m_random = CreateObject<UniformRandomVariable>();
@@ -115,7 +123,7 @@ NTorrentAdHocApp::OnInterest(shared_ptr<const Interest> interest)
     else {
       // this is an Interest for torrent data
       // TODO: Send torrent data
-      if (std::get<1>(m_downloadedData[interestName.get(-1).toSequenceNumber()]) == 1) {
+      if (m_downloadedData.Test(interestName.get(-1).toSequenceNumber())) {
         Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocApp::SendData, this, interestName);
       }
     }
@@ -135,17 +143,29 @@ NTorrentAdHocApp::OnData(shared_ptr<const Data> data)
   if (data->getName().get(0).toUri() == "beacon") {
     // received an IBF
     NS_LOG_DEBUG("Received IBF: " << data->getName().toUri());
-    std::vector<std::tuple<Name, uint32_t, uint32_t>> receivedIBF;
-    DecodeIBFAndComputeRearestPiece(data, &receivedIBF);
-    // TODO: Send Interests for rarest pieces first
-    // For now, send Interests sequentially
-    SendInterestForData(receivedIBF);
+    // decoded once, then shared by the scheduled Interests
+    auto missingPieces = make_shared<PieceBitmap>(m_torrentPacketNum);
+    uint32_t ibfCells = 0;
+    bool isDecoded = DecodeIBFAndComputeRearestPiece(data, missingPieces.get(), &ibfCells);
+    // if the difference was underestimated, ask once for a larger IBF (the
+    // name of a retry has an explicit size component). Overheard replies to
+    // the beacons of other nodes were sized for their pieces, not ours
+    const Name& ibfName = data->getName();
+    bool isOurBeacon = ibfName.size() == 5 &&
+                       ibfName.get(2) == ::ndn::name::Component("node" + std::to_string(m_nodeId));
+    if (!isDecoded && ibfCells != 0 && isOurBeacon) {
+      Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocApp::SendIBFRetry, this, GetIBFSize(uint64_t(4) * ibfCells));
+    }
+    // send Interests for the rarest pieces first
+    SendInterestForData(missingPieces);
   }
   else {
     // Logic for receiving a data packet
     NS_LOG_DEBUG("Received torrent data: " << data->getName().toUri());
-    if (std::get<1>(m_downloadedData[data->getName().get(-1).toSequenceNumber()]) == 0) {
-      m_downloadedData[data->getName().get(-1).toSequenceNumber()].second = 1;
+    uint32_t seq = data->getName().get(-1).toSequenceNumber();
+    if (seq < m_downloadedData.GetSize() && !m_downloadedData.Test(seq)) {
+      m_downloadedData.Set(seq);
+      InsertPiece(seq);
     }
   }
 }
@@ -154,7 +174,7 @@ void
 NTorrentAdHocApp::SendBeacon()
 {
   // Send a beacon
-  Name beaconName = Name("beacon" + m_torrentPrefix.toUri() + "/node" + std::to_string(m_nodeId));
+  Name beaconName = MakeBeaconName();
   beaconName.appendSequenceNumber(m_seq);
   m_seq++;
   NS_LOG_DEBUG("Sending beacon: " << beaconName.toUri());
@@ -167,52 +187,75 @@ NTorrentAdHocApp::SendBeacon()
   Simulator::Schedule(ns3::MilliSeconds(m_beaconTimer.GetMilliSeconds() + m_random->GetValue()), &NTorrentAdHocApp::SendBeacon, this);
 }
 
+Name
+NTorrentAdHocApp::MakeBeaconName() const
+{
+  Name beaconName = Name("beacon" + m_torrentPrefix.toUri() + "/node" + std::to_string(m_nodeId));
+  std::vector<uint8_t> strata;
+  m_strata.WireEncode(strata);
+  beaconName.append(strata.data(), strata.size());
+  return beaconName;
+}
+
+void
+NTorrentAdHocApp::SendIBFRetry(uint32_t ibfCells)
+{
+  Name beaconName = MakeBeaconName();
+  beaconName.appendNumber(ibfCells);
+  beaconName.appendSequenceNumber(m_seq);
+  m_seq++;
+  NS_LOG_DEBUG("Sending beacon for an IBF of " << ibfCells << " cells");
+
+  shared_ptr<Interest> beacon = make_shared<Interest>(beaconName);
+
+  m_transmittedInterests(beacon, this, m_face);
+  m_appLink->onReceiveInterest(*beacon);
+}
+
 void
 NTorrentAdHocApp::PopulateIBF()
 {
   NS_LOG_DEBUG("Populate IBF with data");
-  // loop through all the data packets of the torrent
-  for (auto i = 0; i < m_torrentPacketNum; i++) {
-    // create the ibf tuple and push it back to the vector
-    Name torrentPacketName = Name(m_torrentPrefix.toUri()).appendSequenceNumber(i);
-    std::tuple<Name, uint32_t, uint32_t> ibfTuple;
-    std::pair<Name, uint32_t> dataPair;
-    if (m_isTorrentProducer) {
-      // if this is the original torrent producer
-      ibfTuple = std::make_tuple(torrentPacketName, m_nodeId, 1);
-      dataPair = std::make_pair(torrentPacketName, 1);
-    }
-    else {
-      // if this is not the original torrent producer
-      ibfTuple = std::make_tuple(torrentPacketName, m_nodeId, 0);
-      dataPair = std::make_pair(torrentPacketName, 0);
+  m_IBFs.clear();
+  m_strata = StrataEstimator(m_torrentPacketNum);
+  m_downloadedData.Resize(m_torrentPacketNum);
+  m_availability.Reset(m_torrentPacketNum);
+  if (m_isTorrentProducer) {
+    // the original torrent producer has all the data packets
+    m_downloadedData.SetAll();
+    for (uint32_t i = 0; i < m_torrentPacketNum; i++) {
+      m_strata.Insert(i);
     }
-    m_IBF.push_back(ibfTuple);
-    m_downloadedData.push_back(dataPair);
   }
 }
 
 void
 NTorrentAdHocApp::CreateAndSendIBF(shared_ptr<const Interest> interest)
 {
-  shared_ptr<Data> data = make_shared<Data>(interest->getName());
-
-  // minor optimization: encode the IBF again only if its content has changed
-  // since the last time that it was encoded
-  if (m_IBFhasChanged) {
-    ::ndn::EncodingEstimator estimator;
-    size_t estimatedSize = EncodeContent(estimator);
-
-    ::ndn::EncodingBuffer buffer(estimatedSize, 0);
-    EncodeContent(buffer);
-
-    m_encodedIBF = buffer.block();
-
-    m_IBFhasChanged = false;
+  const Name& beaconName = interest->getName();
+  shared_ptr<Data> data = make_shared<Data>(beaconName);
+
+  // size the IBF: a retry carries an explicit size, otherwise estimate the
+  // difference of the piece sets with the strata estimator of the beacon
+  uint32_t nCells = GetIBFSize(0);
+  if (beaconName.size() == 6 && beaconName.get(4).isNumber()) {
+    nCells = GetIBFSize(beaconName.get(4).toNumber());
+  }
+  else if (beaconName.size() == 5) {
+    StrataEstimator strata(m_torrentPacketNum);
+    const ::ndn::name::Component& strataComp = beaconName.get(3);
+    if (strata.WireDecode(strataComp.value(), strataComp.value_size())) {
+      uint32_t difference = m_strata.EstimateDifference(strata);
+      nCells = GetIBFSize(uint64_t(2) * difference);
+      NS_LOG_DEBUG("Estimated difference: " << difference << ", IBF cells: " << nCells);
+    }
   }
 
+  // the encoded IBF is kept up to date, so it is only copied
+  const std::vector<uint8_t>& wire = GetIBF(nCells).wire;
+
   data->setContentType(::ndn::tlv::ContentType_Blob);
-  data->setContent(m_encodedIBF);
+  data->setContent(::ndn::Block(wire.data(), wire.size()));
 
   Signature signature;
   SignatureInfo signatureInfo(static_cast< ::ndn::tlv::SignatureTypeValue>(255));
@@ -234,141 +277,169 @@ NTorrentAdHocApp::CreateAndSendIBF(shared_ptr<const Interest> interest)
 
 template<::ndn::encoding::Tag TAG>
 size_t
-NTorrentAdHocApp::EncodeContent(::ndn::EncodingImpl<TAG>& encoder) const
+NTorrentAdHocApp::EncodeContent(::ndn::EncodingImpl<TAG>& encoder, const InvertibleBloomFilter& ibf) const
 {
   size_t totalLength = 0;
 
-  for (auto it = m_IBF.rbegin(); it != m_IBF.rend(); it++) {
-    // send only the entries for which the node has downloaded the data
-    uint32_t seq = std::get<0>(*it).get(-1).toSequenceNumber();
-    if (std::get<1>(m_downloadedData[seq]) == 0)
-      continue;
-    // encode the last element of an entry first (counter)
-    uint32_t counter = std::get<2>(*it);
-    totalLength += encoder.prependByteArray(reinterpret_cast<uint8_t*>(&counter), sizeof(counter));
-    totalLength += encoder.prependVarNumber(sizeof(counter));
-    totalLength += encoder.prependVarNumber(128);
-    // encode the second element (nonce)
-    uint32_t nonce = std::get<1>(*it);
-    totalLength += encoder.prependByteArray(reinterpret_cast<uint8_t*>(&nonce), sizeof(nonce));
-    totalLength += encoder.prependVarNumber(sizeof(nonce));
-    totalLength += encoder.prependVarNumber(129);
-    // encode the first element (torrent packet name)
-    totalLength += std::get<0>(*it).wireEncode(encoder);
-  }
+  // the packed cell arrays follow the torrent prefix
+  std::vector<uint8_t> cells(ibf.GetWireSize());
+  ibf.WireEncode(cells.data());
+  totalLength += encoder.prependByteArray(cells.data(), cells.size());
+  totalLength += m_torrentPrefix.wireEncode(encoder);
 
   totalLength += encoder.prependVarNumber(totalLength);
   totalLength += encoder.prependVarNumber(::ndn::tlv::Content);
   return totalLength;
 }
 
-void
+bool
 NTorrentAdHocApp::DecodeIBFAndComputeRearestPiece(shared_ptr<const Data> data,
-                                                  std::vector<std::tuple<Name, uint32_t, uint32_t>>* receivedIBF)
+                                                  PieceBitmap* missingPieces,
+                                                  uint32_t* ibfCells)
 {
+  *ibfCells = 0;
   // decode the received IBF content
   if (data->getContentType() != ::ndn::tlv::ContentType_Blob) {
     NS_LOG_ERROR("Expected Content Type Blob");
-    return;
+    return false;
   }
 
+  // the content is the torrent prefix followed by the packed cell arrays
   const Block& content = data->getContent();
-  content.parse();
+  bool isOk = false;
+  Block prefixBlock;
+  std::tie(isOk, prefixBlock) = Block::fromBuffer(content.value(), content.value_size());
+  if (!isOk || prefixBlock.type() != ::ndn::tlv::Name || Name(prefixBlock) != m_torrentPrefix) {
+    NS_LOG_ERROR("IBF for an unknown torrent");
+    return false;
+  }
 
-  auto element = content.elements_begin();
-  if (content.elements_end() == element) {
-    NS_LOG_ERROR("IBF with empty content");
-    return;
+  InvertibleBloomFilter receivedIBF;
+  if (!receivedIBF.WireDecode(content.value() + prefixBlock.size(),
+                              content.value_size() - prefixBlock.size())) {
+    NS_LOG_ERROR("IBF with a size that is not a multiple of the number of hashes");
+    return false;
   }
 
-  // construct the received IBF data structure
-  for (; element != content.elements_end(); ++element) {
-    // decode the data packet name first
-    element->parse();
-    Name packetName(*element);
-    if (packetName.empty()) {
-      NS_LOG_ERROR("Empty data packet name in the IBF");
-      return;
-    }
+  *ibfCells = receivedIBF.GetSize();
 
-    // decode the nonce
-    element++;
-    uint32_t nonce = 0;
-    if (element->type() == 129) {
-      if (element->value_size() != sizeof(nonce)) {
-        NS_LOG_ERROR("Malformed nonce in the IBF");
-        return;
-      }
-      std::memcpy(&nonce, element->value(), sizeof(nonce));
-    }
-    else {
-      NS_LOG_ERROR("Nonce with malformed TLV number in the IBF");
-      return;
-    }
+  // the difference of the two IBFs holds the pieces only one of the peers has.
+  // Only the sizes we offer ourselves are cached, so that peers cannot grow
+  // the cache, and an IBF of any other size is built for the occasion
+  uint32_t nCells = receivedIBF.GetSize();
+  if (GetIBFSize(nCells) == nCells) {
+    receivedIBF.Subtract(GetIBF(nCells).ibf);
+  }
+  else {
+    InvertibleBloomFilter ibf(nCells);
+    FillIBF(ibf);
+    receivedIBF.Subtract(ibf);
+  }
 
-    // decode the counter
-    // decode the nonce
-    element++;
-    uint32_t counter = 0;
-    if (element->type() == 128) {
-      if (element->value_size() != sizeof(counter)) {
-        NS_LOG_ERROR("Malformed counter in the IBF");
-        return;
-      }
-      std::memcpy(&counter, element->value(), sizeof(counter));
-    }
-    else {
-      NS_LOG_ERROR("Counter with malformed TLV number in the IBF");
-      return;
-    }
+  std::vector<uint32_t> onlyTheirs;
+  std::vector<uint32_t> onlyOurs;
+  bool isDecoded = receivedIBF.Decode(onlyTheirs, onlyOurs);
+  // the pieces peeled so far are valid even if the difference was too large to
+  // be fully decoded (keys out of range, which only a corrupted IBF can
+  // produce, are ignored by the bitmap)
+  for (uint32_t seq : onlyTheirs) {
+    missingPieces->Set(seq);
+    m_availability.Add(seq, Simulator::Now());
+  }
+  if (!isDecoded) {
+    NS_LOG_DEBUG("IBF difference too large to be fully decoded: " << data->getName().toUri()
+                 << ", missing pieces: " << onlyTheirs.size());
+    return false;
+  }
+  NS_LOG_DEBUG("IBF decoded successfully: " << data->getName().toUri() << ", missing pieces: "
+               << onlyTheirs.size() << ", pieces only we have: " << onlyOurs.size());
+  return true;
+}
 
-    receivedIBF->push_back(std::make_tuple(packetName, nonce, counter));
+uint32_t
+NTorrentAdHocApp::GetIBFSize(uint64_t minCells) const
+{
+  // an IBF of twice as many cells as pieces can hold any difference
+  uint32_t step = InvertibleBloomFilter::N_HASHES;
+  uint64_t nCells = (std::max<uint32_t>(m_ibfCells, 1) + step - 1) / step * step;
+  uint64_t maxCells = uint64_t(2) * m_torrentPacketNum;
+  while (nCells < minCells && nCells < maxCells) {
+    nCells *= 2;
+  }
+  return static_cast<uint32_t>(nCells);
+}
 
-    // Making sure we encode and decode in the right way
-    // std::cerr << "Name: " << packetName.toUri() << std::endl;
-    // std::cerr << "Counter: " << counter << std::endl;
-    // std::cerr << "Nonce: " << nonce << std::endl;
+NTorrentAdHocApp::EncodedIBF&
+NTorrentAdHocApp::GetIBF(uint32_t nCells)
+{
+  auto encoded = m_IBFs.find(nCells);
+  if (encoded == m_IBFs.end()) {
+    encoded = m_IBFs.emplace(nCells, EncodedIBF()).first;
+    InvertibleBloomFilter& ibf = encoded->second.ibf;
+    ibf.Resize(nCells);
+    FillIBF(ibf);
+
+    ::ndn::EncodingEstimator estimator;
+    size_t estimatedSize = EncodeContent(estimator, ibf);
+
+    ::ndn::EncodingBuffer buffer(estimatedSize, 0);
+    EncodeContent(buffer, ibf);
+
+    encoded->second.wire.assign(buffer.buf(), buffer.buf() + buffer.size());
   }
-  NS_LOG_DEBUG("IBF decoded successfully: " << data->getName().toUri());
-  // TODO: Apply the data scarcity estimation logic
+  return encoded->second;
+}
+
+void
+NTorrentAdHocApp::FillIBF(InvertibleBloomFilter& ibf) const
+{
+  m_downloadedData.ForEachSet([&ibf] (uint32_t seq) { ibf.Insert(seq); });
+}
+
+void
+NTorrentAdHocApp::InsertPiece(uint32_t seq)
+{
+  m_strata.Insert(seq);
 
+  for (auto& entry : m_IBFs) {
+    EncodedIBF& encoded = entry.second;
+    encoded.ibf.Insert(seq);
+
+    // the cell arrays are at the end of the Content block
+    uint8_t* cells = encoded.wire.data() + encoded.wire.size() - encoded.ibf.GetWireSize();
+    for (uint32_t h = 0; h < InvertibleBloomFilter::N_HASHES; h++) {
+      encoded.ibf.WireEncodeCell(encoded.ibf.GetCellIndex(seq, h), cells);
+    }
+  }
 }
 
 void
-NTorrentAdHocApp::SendInterestForData(std::vector<std::tuple<Name, uint32_t, uint32_t>> receivedIBF,
-                                      uint32_t interestsSent)
+NTorrentAdHocApp::SendInterestForData(shared_ptr<PieceBitmap> peerPieces, uint32_t interestsSent)
 {
-  // For now, just find the next missing data piece that the node that sent
-  // its IBF has already downloaded. For each received IBF, try to fetch
-  // MAX_PACKETS_TO_FETCH packets
-  // TODO: Fetch the rarest piece
+  // For each received IBF, try to fetch MAX_PACKETS_TO_FETCH packets
   if (interestsSent == MAX_PACKETS_TO_FETCH) {
     return;
   }
 
-  // Find the first missing data packet that the other node has
-  for (auto it1 = m_downloadedData.begin(); it1 != m_downloadedData.end(); it1++) {
-    // find the first missing data packet
-    if (std::get<1>(*it1) == 1) {
-      continue;
-    }
-    for (auto it2 = receivedIBF.begin(); it2 != receivedIBF.end(); it2++) {
-      // check if the other node has this data packet
-      if (std::get<0>(*it1).toUri() != std::get<0>(*it2).toUri()) {
-        continue;
-      }
-      shared_ptr<Interest> interest = make_shared<Interest>(std::get<0>(*it1));
+  // Find the rarest piece the other node has that is still missing. Pieces
+  // received since the IBF was decoded are skipped
+  uint32_t seq = m_availability.FindRarest(*peerPieces, m_downloadedData);
+  if (seq == PieceBitmap::NO_PIECE) {
+    return;
+  }
+  peerPieces->Reset(seq);
 
-      NS_LOG_DEBUG("Sending Interest for torrent data: " << std::get<0>(*it1));
+  Name packetName = Name(m_torrentPrefix).appendSequenceNumber(seq);
+  shared_ptr<Interest> interest = make_shared<Interest>(packetName);
 
-      m_transmittedInterests(interest, this, m_face);
-      m_appLink->onReceiveInterest(*interest);
+  NS_LOG_DEBUG("Sending Interest for torrent data: " << packetName << ", availability: "
+               << m_availability.GetScore(seq, Simulator::Now()));
 
-      Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocApp::SendInterestForData, this, receivedIBF, interestsSent + 1);
+  m_transmittedInterests(interest, this, m_face);
+  m_appLink->onReceiveInterest(*interest);
 
-      return;
-    }
-  }
+  // the next Interest goes for the next rarest piece
+  Simulator::Schedule(ns3::MilliSeconds(m_random->GetValue()), &NTorrentAdHocApp::SendInterestForData, this, peerPieces, interestsSent + 1);
 }
 
 void
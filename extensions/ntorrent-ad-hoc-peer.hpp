@@ -45,6 +45,11 @@
 #include "src/util/simulation-constants.hpp"
 #include "src/util/io-util.hpp"
 
+#include "ntorrent-ibf.hpp"
+#include "ntorrent-piece-availability.hpp"
+#include "ntorrent-piece-bitmap.hpp"
+
+#include <map>
 #include <tuple>
 
 #define MAX_PACKETS_TO_FETCH 5
@@ -86,25 +91,85 @@ private:
   void
   SendBeacon();
 
+  /**
+   * @brief name of a beacon, carrying the strata estimator of our pieces
+   */
+  Name
+  MakeBeaconName() const;
+
+  /**
+   * @brief send a beacon asking for an IBF of (at least) ibfCells cells
+   */
+  void
+  SendIBFRetry(uint32_t ibfCells);
+
   void
   PopulateIBF();
 
   void
   CreateAndSendIBF(shared_ptr<const Interest> interest);
 
+  /**
+   * @brief decode the IBF of a peer and subtract ours from it, recording the
+   * pieces the peer has in the swarm availability
+   * @param missingPieces set in it are the pieces the peer has and we are
+   *        missing (sized to the number of torrent pieces)
+   * @param ibfCells set to the number of cells of the received IBF
+   * @return true if the difference has been fully decoded
+   */
+  bool
+  DecodeIBFAndComputeRearestPiece(shared_ptr<const Data> data, PieceBitmap* missingPieces,
+                                  uint32_t* ibfCells);
+
+  /**
+   * @brief smallest IBF size of the ladder (IbfCells times a power of 2)
+   * with at least minCells cells, up to the size that fits all the pieces
+   */
+  uint32_t
+  GetIBFSize(uint64_t minCells) const;
+
+  // IBF of our pieces and its wire encoding (the Content block of the
+  // beacon replies)
+  struct EncodedIBF
+  {
+    InvertibleBloomFilter ibf;
+    std::vector<uint8_t> wire;
+  };
+
+  /**
+   * @brief IBF of our pieces with nCells cells (a size of the GetIBFSize
+   * ladder), built and encoded on first use
+   */
+  EncodedIBF&
+  GetIBF(uint32_t nCells);
+
+  /**
+   * @brief insert our pieces into an empty IBF
+   */
   void
-  DecodeIBFAndComputeRearestPiece(shared_ptr<const Data> data, std::vector<std::tuple<Name, uint32_t, uint32_t>>* receivedIBF);
+  FillIBF(InvertibleBloomFilter& ibf) const;
+
+  /**
+   * @brief add a new piece to the IBFs, patching the changed cells of their
+   * wire encoding in place
+   */
+  void
+  InsertPiece(uint32_t seq);
 
   /**
    * @brief encode IBF
    */
   template<::ndn::encoding::Tag TAG>
   size_t
-  EncodeContent(::ndn::EncodingImpl<TAG>& encoder) const;
+  EncodeContent(::ndn::EncodingImpl<TAG>& encoder, const InvertibleBloomFilter& ibf) const;
 
+  /**
+   * @brief send an Interest for the rarest piece in the swarm that the peer
+   * has and we are still missing, and schedule the next one
+   * @param peerPieces the pieces of the peer not requested yet
+   */
   void
-  SendInterestForData(std::vector<std::tuple<Name, uint32_t, uint32_t>> receivedIBF,
-                      uint32_t interestsSent = 0);
+  SendInterestForData(shared_ptr<PieceBitmap> peerPieces, uint32_t interestsSent = 0);
 
   void
   SendData(Name interestName);
@@ -114,30 +179,34 @@ private:
   Name m_torrentPrefix;
   bool m_isTorrentProducer;
   uint32_t m_nodeId;
+  uint32_t m_ibfCells;
 
   Time m_beaconTimer;
   Time m_randomTimerRange;
+  Time m_availabilityHalfLife;
 
   Ptr<RandomVariableStream> m_random;
 
   // sequence number used for beacons
   uint64_t m_seq;
 
-  // IBF-like data structure. It contains tuples of
-  // <torrent packet name, nonce, counter>
-  std::vector<std::tuple<Name, uint32_t, uint32_t>> m_IBF;
+  // IBFs of the sequence numbers of the data packets the node has, one per
+  // size of the GetIBFSize ladder used in the exchanges with the peers
+  // <cells, IBF>, so at most log2(2 * pieces / IbfCells) + 1 of them. Their
+  // wire encodings are kept up to date as pieces arrive
+  std::map<uint32_t, EncodedIBF> m_IBFs;
 
-  // Structure for the data a node has. It contains pairs of
-  // <data packet name, value that indicates whether the nodes has this data packet>
-  // 1 if the node has this data packet, 0 if it does not
-  std::vector<std::pair<Name, uint32_t>> m_downloadedData;
+  // strata estimator of the data packets the node has, sent in the beacons
+  // so that peers can size their IBF to the difference of the piece sets
+  StrataEstimator m_strata;
 
-  // store the encoded IBF block
-  ::ndn::Block m_encodedIBF;
+  // Structure for the data a node has (bit set if the node has the data
+  // packet, clear if it does not)
+  PieceBitmap m_downloadedData;
 
-  // boolean to check whether the IBF has changed since the last time
-  // that was encoded
-  bool m_IBFhasChanged;
+  // number of peers recently found to hold each piece, from the decoded IBF
+  // differences, halving every m_availabilityHalfLife
+  PieceAvailability m_availability;
 
   // outstanding Interests (data packets for which an Interest has been sent, but a
   // data packet has not been received yet
@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-bitmap-advertisement.hpp"
+#include "ntorrent-varint.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+BitmapAdvertisement::BitmapAdvertisement()
+  : sender(0)
+  , version(0)
+  , base(0)
+  , payload(nullptr)
+  , payloadSize(0)
+{
+}
+
+uint32_t
+BitmapAdvertisement::GetAck(uint32_t node) const
+{
+  for (const auto& ack : acks) {
+    if (ack.first == node)
+      return ack.second;
+  }
+  return 0;
+}
+
+void
+BitmapAdvertisement::EncodeHeader(std::vector<uint8_t>& wire) const
+{
+  wire.clear();
+  appendVarint(wire, sender);
+  appendVarint(wire, version);
+  appendVarint(wire, base);
+  appendVarint(wire, acks.size());
+  for (const auto& ack : acks) {
+    appendVarint(wire, ack.first);
+    appendVarint(wire, ack.second);
+  }
+}
+
+void
+BitmapAdvertisement::WireEncodeFull(const PieceBitmap& bitmap, std::vector<uint8_t>& wire) const
+{
+  std::vector<uint8_t> compact;
+  bitmap.EncodeCompact(compact);
+
+  EncodeHeader(wire);
+  wire.insert(wire.end(), compact.begin(), compact.end());
+}
+
+void
+BitmapAdvertisement::WireEncodeDelta(const uint32_t* gained, size_t nGained,
+                                     std::vector<uint8_t>& wire) const
+{
+  EncodeHeader(wire);
+  for (size_t i = 0; i < nGained; i++) {
+    appendVarint(wire, gained[i]);
+  }
+}
+
+bool
+BitmapAdvertisement::WireDecode(const uint8_t* wire, size_t size)
+{
+  const uint8_t* it = wire;
+  const uint8_t* end = wire + size;
+
+  uint32_t nAcks;
+  if (!readVarint(it, end, sender) || !readVarint(it, end, version) ||
+      !readVarint(it, end, base) || !readVarint(it, end, nAcks))
+    return false;
+  // a delta cannot go backwards
+  if (base > version)
+    return false;
+
+  acks.clear();
+  for (uint32_t i = 0; i < nAcks; i++) {
+    uint32_t node, nodeVersion;
+    if (!readVarint(it, end, node) || !readVarint(it, end, nodeVersion))
+      return false;
+    acks.emplace_back(node, nodeVersion);
+  }
+
+  payload = it;
+  payloadSize = end - it;
+  return true;
+}
+
+bool
+BitmapAdvertisement::Apply(PieceBitmap& bitmap) const
+{
+  if (base == 0)
+    return bitmap.DecodeCompact(payload, payloadSize);
+
+  const uint8_t* it = payload;
+  const uint8_t* end = payload + payloadSize;
+  while (it != end) {
+    uint32_t seq;
+    if (!readVarint(it, end, seq) || seq >= bitmap.GetSize())
+      return false;
+    bitmap.Set(seq);
+  }
+  return true;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,101 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_BITMAP_ADVERTISEMENT_HPP
+#define NTORRENT_BITMAP_ADVERTISEMENT_HPP
+
+#include "ntorrent-piece-bitmap.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Versioned bitmap advertisement of a peer
+ *
+ * A peer bitmap starts at version 1 and every gained piece increments the
+ * version. An advertisement either carries the full bitmap (base 0) or only
+ * the pieces gained between version base and version, in which case it can
+ * be applied to any bitmap of the sender known at version base or later.
+ *
+ * The wire encoding is a sequence of varints: sender, version, base, number
+ * of acks, the <node, version> acks, then either the compact encoding of the
+ * full bitmap or the sequence numbers of the gained pieces.
+ */
+struct BitmapAdvertisement
+{
+  BitmapAdvertisement();
+
+  /**
+   * @brief version of the bitmap of node known by the sender (0 if unknown)
+   */
+  uint32_t
+  GetAck(uint32_t node) const;
+
+  /**
+   * @brief replace wire with this advertisement carrying the full bitmap
+   */
+  void
+  WireEncodeFull(const PieceBitmap& bitmap, std::vector<uint8_t>& wire) const;
+
+  /**
+   * @brief replace wire with this advertisement carrying nGained gained pieces
+   */
+  void
+  WireEncodeDelta(const uint32_t* gained, size_t nGained, std::vector<uint8_t>& wire) const;
+
+  /**
+   * @brief decode the advertisement. The payload keeps pointing into wire
+   * @return false if the advertisement is malformed
+   */
+  bool
+  WireDecode(const uint8_t* wire, size_t size);
+
+  /**
+   * @brief apply the payload to bitmap: replace it if this is a full bitmap,
+   * add the gained pieces otherwise
+   * @return false if the payload is malformed, in which case the content of
+   *         bitmap is unspecified
+   */
+  bool
+  Apply(PieceBitmap& bitmap) const;
+
+  uint32_t sender;
+  uint32_t version;
+  uint32_t base;
+  // <node, version of the bitmap of node known by the sender>
+  std::vector<std::pair<uint32_t, uint32_t>> acks;
+
+  // full compact bitmap or gained pieces, filled by WireDecode
+  const uint8_t* payload;
+  size_t payloadSize;
+
+private:
+  void
+  EncodeHeader(std::vector<uint8_t>& wire) const;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_BITMAP_ADVERTISEMENT_HPP
@@ -0,0 +1,93 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-duplicate-cache.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+// FNV-1a over a byte range, continuing from hash
+static uint64_t
+hashBytes(const uint8_t* begin, const uint8_t* end, uint64_t hash = FNV_OFFSET_BASIS)
+{
+  for (const uint8_t* it = begin; it != end; ++it) {
+    hash = (hash ^ *it) * FNV_PRIME;
+  }
+  return hash;
+}
+
+DuplicateCache::DuplicateCache(size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+void
+DuplicateCache::SetCapacity(size_t capacity)
+{
+  m_capacity = capacity;
+  Evict();
+}
+
+bool
+DuplicateCache::Insert(uint64_t key)
+{
+  if (m_capacity == 0)
+    return true;
+
+  if (!m_keys.insert(key).second)
+    return false;
+
+  m_fifo.push_back(key);
+  Evict();
+  return true;
+}
+
+void
+DuplicateCache::Evict()
+{
+  while (m_fifo.size() > m_capacity) {
+    m_keys.erase(m_fifo.front());
+    m_fifo.pop_front();
+  }
+}
+
+uint64_t
+DuplicateCache::GetKey(const ::ndn::Interest& interest)
+{
+  const ::ndn::Block& name = interest.getName().wireEncode();
+  uint32_t nonce = interest.getNonce();
+  uint64_t hash = hashBytes(name.wire(), name.wire() + name.size());
+  const uint8_t* nonceBytes = reinterpret_cast<const uint8_t*>(&nonce);
+  return hashBytes(nonceBytes, nonceBytes + sizeof(nonce), hash);
+}
+
+uint64_t
+DuplicateCache::GetKey(const ::ndn::Data& data)
+{
+  const ::ndn::Block& wire = data.wireEncode();
+  return hashBytes(wire.wire(), wire.wire() + wire.size());
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,98 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_DUPLICATE_CACHE_HPP
+#define NTORRENT_DUPLICATE_CACHE_HPP
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/interest.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Bounded set of recently relayed packets
+ *
+ * Packets are identified by a 64-bit key: the hash of the name and the Nonce
+ * of an Interest, or the hash of the wire encoding of a Data packet. When the
+ * cache is full the oldest key is dropped (FIFO), so a copy of a packet is
+ * recognized as long as fewer than capacity other packets were heard since.
+ * A capacity of 0 disables the cache.
+ */
+class DuplicateCache
+{
+public:
+  explicit
+  DuplicateCache(size_t capacity = 1000);
+
+  void
+  SetCapacity(size_t capacity);
+
+  size_t
+  GetCapacity() const
+  {
+    return m_capacity;
+  }
+
+  size_t
+  GetSize() const
+  {
+    return m_fifo.size();
+  }
+
+  /**
+   * @brief add a key to the cache
+   * @return false if the key is already in the cache
+   */
+  bool
+  Insert(uint64_t key);
+
+  bool
+  Contains(uint64_t key) const
+  {
+    return m_keys.count(key) != 0;
+  }
+
+  static uint64_t
+  GetKey(const ::ndn::Interest& interest);
+
+  static uint64_t
+  GetKey(const ::ndn::Data& data);
+
+private:
+  void
+  Evict();
+
+private:
+  size_t m_capacity;
+  std::unordered_set<uint64_t> m_keys;
+  // keys in insertion order
+  std::deque<uint64_t> m_fifo;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_DUPLICATE_CACHE_HPP
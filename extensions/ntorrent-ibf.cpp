@@ -0,0 +1,330 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-ibf.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+namespace ndn {
+
+const uint32_t InvertibleBloomFilter::N_HASHES;
+const uint32_t StrataEstimator::CELLS_PER_STRATUM;
+
+// finalizer of MurmurHash3, a cheap mixing of all the bits of the key
+static inline uint32_t
+mix(uint32_t key, uint32_t seed)
+{
+  uint32_t h = key ^ seed;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static const uint32_t CHECKSUM_SEED = 0x9e3779b9;
+static const uint32_t STRATUM_SEED = 0x7f4a7c15;
+
+// the wire encoding is little-endian, like the piece bitmaps
+static inline uint32_t
+toLittleEndian(uint32_t value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap32(value);
+#else
+  return value;
+#endif
+}
+
+static void
+encodeArray(const uint32_t* values, size_t n, uint8_t* buffer)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t i = 0; i < n; i++) {
+    uint32_t value = toLittleEndian(values[i]);
+    std::memcpy(buffer + 4 * i, &value, sizeof(value));
+  }
+#else
+  std::memcpy(buffer, values, 4 * n);
+#endif
+}
+
+static void
+decodeArray(const uint8_t* buffer, size_t n, uint32_t* values)
+{
+  std::memcpy(values, buffer, 4 * n);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t i = 0; i < n; i++) {
+    values[i] = toLittleEndian(values[i]);
+  }
+#endif
+}
+
+static inline void
+encodeValue(uint32_t value, uint8_t* buffer)
+{
+  value = toLittleEndian(value);
+  std::memcpy(buffer, &value, sizeof(value));
+}
+
+InvertibleBloomFilter::InvertibleBloomFilter()
+{
+}
+
+InvertibleBloomFilter::InvertibleBloomFilter(uint32_t nCells)
+{
+  Resize(nCells);
+}
+
+void
+InvertibleBloomFilter::Resize(uint32_t nCells)
+{
+  uint32_t partitionSize = (nCells + N_HASHES - 1) / N_HASHES;
+  if (partitionSize == 0)
+    partitionSize = 1;
+  m_counts.assign(partitionSize * N_HASHES, 0);
+  m_keySums.assign(partitionSize * N_HASHES, 0);
+  m_hashSums.assign(partitionSize * N_HASHES, 0);
+}
+
+void
+InvertibleBloomFilter::Insert(uint32_t key)
+{
+  Update(key, 1);
+}
+
+void
+InvertibleBloomFilter::Erase(uint32_t key)
+{
+  Update(key, -1);
+}
+
+bool
+InvertibleBloomFilter::Subtract(const InvertibleBloomFilter& other)
+{
+  if (other.GetSize() != GetSize())
+    return false;
+
+  for (size_t i = 0; i < m_counts.size(); i++) {
+    m_counts[i] -= other.m_counts[i];
+  }
+  for (size_t i = 0; i < m_keySums.size(); i++) {
+    m_keySums[i] ^= other.m_keySums[i];
+  }
+  for (size_t i = 0; i < m_hashSums.size(); i++) {
+    m_hashSums[i] ^= other.m_hashSums[i];
+  }
+  return true;
+}
+
+bool
+InvertibleBloomFilter::Decode(std::vector<uint32_t>& inThis, std::vector<uint32_t>& inOther) const
+{
+  InvertibleBloomFilter peeled(*this);
+
+  std::vector<uint32_t> pureCells;
+  for (uint32_t i = 0; i < peeled.GetSize(); i++) {
+    if (peeled.IsPure(i))
+      pureCells.push_back(i);
+  }
+
+  while (!pureCells.empty()) {
+    uint32_t i = pureCells.back();
+    pureCells.pop_back();
+    // the cell may have changed since it was found pure
+    if (!peeled.IsPure(i))
+      continue;
+
+    uint32_t key = peeled.m_keySums[i];
+    int32_t sign = peeled.m_counts[i];
+    if (sign > 0)
+      inThis.push_back(key);
+    else
+      inOther.push_back(key);
+
+    // removing the key from its cells may make them pure
+    peeled.Update(key, -sign);
+    for (uint32_t h = 0; h < N_HASHES; h++) {
+      uint32_t j = peeled.GetCellIndex(key, h);
+      if (peeled.IsPure(j))
+        pureCells.push_back(j);
+    }
+  }
+
+  for (uint32_t i = 0; i < peeled.GetSize(); i++) {
+    if (!peeled.GetCell(i).IsEmpty())
+      return false;
+  }
+  return true;
+}
+
+uint32_t
+InvertibleBloomFilter::GetCellIndex(uint32_t key, uint32_t i) const
+{
+  uint32_t partitionSize = m_counts.size() / N_HASHES;
+  return i * partitionSize + mix(key, i + 1) % partitionSize;
+}
+
+void
+InvertibleBloomFilter::WireEncode(uint8_t* buffer) const
+{
+  size_t n = GetSize();
+  // the counts are encoded as their two's complement
+  encodeArray(reinterpret_cast<const uint32_t*>(m_counts.data()), n, buffer);
+  encodeArray(m_keySums.data(), n, buffer + 4 * n);
+  encodeArray(m_hashSums.data(), n, buffer + 8 * n);
+}
+
+void
+InvertibleBloomFilter::WireEncodeCell(uint32_t i, uint8_t* buffer) const
+{
+  size_t n = GetSize();
+  encodeValue(static_cast<uint32_t>(m_counts[i]), buffer + 4 * i);
+  encodeValue(m_keySums[i], buffer + 4 * (n + i));
+  encodeValue(m_hashSums[i], buffer + 4 * (2 * n + i));
+}
+
+bool
+InvertibleBloomFilter::WireDecode(const uint8_t* buffer, size_t size)
+{
+  size_t n = size / (3 * sizeof(uint32_t));
+  if (n == 0 || n % N_HASHES != 0 || size != n * 3 * sizeof(uint32_t))
+    return false;
+
+  // every array is a single copy straight from the buffer
+  m_counts.resize(n);
+  m_keySums.resize(n);
+  m_hashSums.resize(n);
+  decodeArray(buffer, n, reinterpret_cast<uint32_t*>(m_counts.data()));
+  decodeArray(buffer + 4 * n, n, m_keySums.data());
+  decodeArray(buffer + 8 * n, n, m_hashSums.data());
+  return true;
+}
+
+void
+InvertibleBloomFilter::Update(uint32_t key, int32_t sign)
+{
+  uint32_t checksum = Checksum(key);
+  for (uint32_t i = 0; i < N_HASHES; i++) {
+    uint32_t j = GetCellIndex(key, i);
+    m_counts[j] += sign;
+    m_keySums[j] ^= key;
+    m_hashSums[j] ^= checksum;
+  }
+}
+
+uint32_t
+InvertibleBloomFilter::Checksum(uint32_t key)
+{
+  return mix(key, CHECKSUM_SEED);
+}
+
+StrataEstimator::StrataEstimator(uint32_t maxKeys)
+{
+  // the last stratum gets the keys of all the sparser strata
+  uint32_t nStrata = 2;
+  for (; nStrata < 32 && (uint64_t(1) << (nStrata - 1)) <= maxKeys; nStrata++) {
+  }
+  m_strata.assign(nStrata, InvertibleBloomFilter(CELLS_PER_STRATUM));
+}
+
+void
+StrataEstimator::Insert(uint32_t key)
+{
+  m_strata[GetStratum(key)].Insert(key);
+}
+
+void
+StrataEstimator::Erase(uint32_t key)
+{
+  m_strata[GetStratum(key)].Erase(key);
+}
+
+uint32_t
+StrataEstimator::EstimateDifference(const StrataEstimator& other) const
+{
+  if (other.m_strata.size() != m_strata.size())
+    return 0;
+
+  uint64_t count = 0;
+  for (size_t i = m_strata.size(); i-- > 0; ) {
+    InvertibleBloomFilter difference(m_strata[i]);
+    difference.Subtract(other.m_strata[i]);
+
+    std::vector<uint32_t> inThis, inOther;
+    if (!difference.Decode(inThis, inOther)) {
+      // strata i + 1 and up hold 1 / 2^(i + 1) of the keys
+      return static_cast<uint32_t>(std::min<uint64_t>((count + 1) << (i + 1), UINT32_MAX));
+    }
+    count += inThis.size() + inOther.size();
+  }
+  return static_cast<uint32_t>(count);
+}
+
+size_t
+StrataEstimator::GetWireSize() const
+{
+  size_t size = 0;
+  for (const InvertibleBloomFilter& stratum : m_strata) {
+    size += stratum.GetWireSize();
+  }
+  return size;
+}
+
+void
+StrataEstimator::WireEncode(std::vector<uint8_t>& wire) const
+{
+  wire.resize(GetWireSize());
+  uint8_t* it = wire.data();
+  for (const InvertibleBloomFilter& stratum : m_strata) {
+    stratum.WireEncode(it);
+    it += stratum.GetWireSize();
+  }
+}
+
+bool
+StrataEstimator::WireDecode(const uint8_t* wire, size_t size)
+{
+  if (size != GetWireSize())
+    return false;
+
+  const uint8_t* it = wire;
+  for (InvertibleBloomFilter& stratum : m_strata) {
+    size_t stratumSize = stratum.GetWireSize();
+    stratum.WireDecode(it, stratumSize);
+    it += stratumSize;
+  }
+  return true;
+}
+
+uint32_t
+StrataEstimator::GetStratum(uint32_t key) const
+{
+  uint32_t h = mix(key, STRATUM_SEED);
+  uint32_t zeros = (h == 0) ? 32 : __builtin_ctz(h);
+  return std::min<uint32_t>(zeros, m_strata.size() - 1);
+}
+
+} // namespace ndn
+} // namespace ns3
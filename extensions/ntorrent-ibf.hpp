@@ -0,0 +1,246 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_IBF_HPP
+#define NTORRENT_IBF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Invertible Bloom filter over 32-bit keys (torrent piece sequence numbers)
+ *
+ * Every key is added to N_HASHES cells, one in each of N_HASHES equal
+ * partitions of the filter. A cell holds the number of keys added to it and
+ * the XOR of the keys and of their checksums. Subtracting the filter of a
+ * peer from ours leaves only the keys of the symmetric difference, which can
+ * be listed by peeling cells that hold a single key, as long as the
+ * difference is small enough for the size of the filter.
+ *
+ * The cells are stored as three arrays: the counts, the key sums and the hash
+ * sums. The wire encoding is these arrays, packed one after the other, of
+ * GetSize() 4-byte little-endian values (the byte order of the piece
+ * bitmaps), so that on little-endian hosts every array is encoded and
+ * decoded with a single bulk copy.
+ */
+class InvertibleBloomFilter
+{
+public:
+  static const uint32_t N_HASHES = 3;
+
+  struct Cell
+  {
+    int32_t count;
+    uint32_t keySum;
+    uint32_t hashSum;
+
+    bool
+    IsEmpty() const
+    {
+      return count == 0 && keySum == 0 && hashSum == 0;
+    }
+  };
+
+  InvertibleBloomFilter();
+
+  /**
+   * @brief create an empty filter of at least nCells cells
+   */
+  explicit
+  InvertibleBloomFilter(uint32_t nCells);
+
+  /**
+   * @brief empty the filter and resize it to at least nCells cells (a
+   * multiple of N_HASHES)
+   */
+  void
+  Resize(uint32_t nCells);
+
+  uint32_t
+  GetSize() const
+  {
+    return m_counts.size();
+  }
+
+  void
+  Insert(uint32_t key);
+
+  void
+  Erase(uint32_t key);
+
+  /**
+   * @brief subtract the filter of a peer, cell by cell
+   * @return false if the filters have different sizes
+   */
+  bool
+  Subtract(const InvertibleBloomFilter& other);
+
+  /**
+   * @brief list the keys of the filter by peeling pure cells
+   *
+   * After a Subtract, the keys with a positive count (only in this filter)
+   * go to inThis and the keys with a negative count (only in the other
+   * filter) to inOther.
+   *
+   * @return true if the filter has been fully peeled. Otherwise the listed
+   *         keys are still correct, but some keys are missing
+   */
+  bool
+  Decode(std::vector<uint32_t>& inThis, std::vector<uint32_t>& inOther) const;
+
+  Cell
+  GetCell(uint32_t i) const
+  {
+    return Cell{m_counts[i], m_keySums[i], m_hashSums[i]};
+  }
+
+  void
+  SetCell(uint32_t i, const Cell& cell)
+  {
+    m_counts[i] = cell.count;
+    m_keySums[i] = cell.keySum;
+    m_hashSums[i] = cell.hashSum;
+  }
+
+  /**
+   * @brief index of the cell of key in partition i (i < N_HASHES)
+   */
+  uint32_t
+  GetCellIndex(uint32_t key, uint32_t i) const;
+
+  /**
+   * @brief size in bytes of the wire encoding
+   */
+  size_t
+  GetWireSize() const
+  {
+    return m_counts.size() * 3 * sizeof(uint32_t);
+  }
+
+  /**
+   * @brief write the wire encoding into buffer (GetWireSize() bytes)
+   */
+  void
+  WireEncode(uint8_t* buffer) const;
+
+  /**
+   * @brief update cell i in the wire encoding of the filter held in buffer
+   */
+  void
+  WireEncodeCell(uint32_t i, uint8_t* buffer) const;
+
+  /**
+   * @brief replace the filter with a wire encoded one, of size / 12 cells
+   * @return false if size is not that of a filter of N_HASHES partitions
+   */
+  bool
+  WireDecode(const uint8_t* buffer, size_t size);
+
+private:
+  /**
+   * @brief add (sign 1) or remove (sign -1) a key
+   */
+  void
+  Update(uint32_t key, int32_t sign);
+
+  static uint32_t
+  Checksum(uint32_t key);
+
+  bool
+  IsPure(uint32_t i) const
+  {
+    return (m_counts[i] == 1 || m_counts[i] == -1) && m_hashSums[i] == Checksum(m_keySums[i]);
+  }
+
+private:
+  std::vector<int32_t> m_counts;
+  std::vector<uint32_t> m_keySums;
+  std::vector<uint32_t> m_hashSums;
+};
+
+/**
+ * @brief Strata estimator of the size of the difference of two key sets
+ *
+ * Keys are spread over strata of small IBFs, stratum i getting the keys whose
+ * hash has i trailing zeros, i.e., about 1 / 2^(i + 1) of the keys. The
+ * difference of two estimators is decoded from the sparsest stratum down to
+ * the first stratum that fails to decode; the difference counted so far is
+ * then scaled by the fraction of keys the decoded strata hold.
+ */
+class StrataEstimator
+{
+public:
+  static const uint32_t CELLS_PER_STRATUM = 12;
+
+  /**
+   * @brief create an empty estimator with enough strata for sets of maxKeys keys
+   */
+  explicit
+  StrataEstimator(uint32_t maxKeys = 0);
+
+  void
+  Insert(uint32_t key);
+
+  void
+  Erase(uint32_t key);
+
+  /**
+   * @brief estimate the size of the symmetric difference with the key set of other
+   * @return the estimate, or 0 if the estimators have different sizes
+   */
+  uint32_t
+  EstimateDifference(const StrataEstimator& other) const;
+
+  /**
+   * @brief size in bytes of the wire encoding
+   */
+  size_t
+  GetWireSize() const;
+
+  /**
+   * @brief replace wire with the encoding of the cells, stratum after stratum
+   */
+  void
+  WireEncode(std::vector<uint8_t>& wire) const;
+
+  /**
+   * @brief replace the cells with a wire encoded estimator of the same size
+   * @return false if the encoding does not match the size of the estimator
+   */
+  bool
+  WireDecode(const uint8_t* wire, size_t size);
+
+private:
+  uint32_t
+  GetStratum(uint32_t key) const;
+
+private:
+  std::vector<InvertibleBloomFilter> m_strata;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_IBF_HPP
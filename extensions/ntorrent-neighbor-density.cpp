@@ -0,0 +1,117 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-neighbor-density.hpp"
+
+#include <ndn-cxx/lp/tags.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+namespace ndn {
+
+static const char NODE_ID_PREFIX[] = "node";
+
+NeighborDensity::NeighborDensity(Time timeout)
+  : m_timeout(timeout)
+{
+}
+
+void
+NeighborDensity::SetTimeout(Time timeout)
+{
+  m_timeout = timeout;
+}
+
+void
+NeighborDensity::Observe(const ::ndn::Interest& interest, Time now)
+{
+  // the link service counts the hops travelled, and relays keep the tag: an
+  // Interest relayed on the way comes from a node that is not a neighbor
+  std::shared_ptr<::ndn::lp::HopCountTag> hopCount = interest.getTag<::ndn::lp::HopCountTag>();
+  if (hopCount != nullptr && *hopCount > 1)
+    return;
+
+  uint32_t nodeId;
+  if (GetOriginator(interest.getName(), nodeId))
+    m_neighbors[nodeId] = now;
+}
+
+uint32_t
+NeighborDensity::GetCount(Time now)
+{
+  for (auto it = m_neighbors.begin(); it != m_neighbors.end(); ) {
+    if (now - it->second > m_timeout)
+      it = m_neighbors.erase(it);
+    else
+      ++it;
+  }
+  return m_neighbors.size();
+}
+
+uint32_t
+NeighborDensity::GetForwardProbability(uint32_t target, uint32_t minProbability, Time now)
+{
+  uint32_t count = GetCount(now);
+  // with no more neighbors than the target, every one of them has to relay
+  if (count <= target)
+    return 100;
+  return std::min<uint32_t>(100, std::max<uint32_t>(minProbability, 100 * target / count));
+}
+
+bool
+NeighborDensity::GetNodeId(const ::ndn::Name& name, uint32_t& nodeId)
+{
+  const size_t prefixSize = sizeof(NODE_ID_PREFIX) - 1;
+  for (const ::ndn::name::Component& component : name) {
+    if (component.value_size() <= prefixSize || component.value_size() > prefixSize + 9 ||
+        std::memcmp(component.value(), NODE_ID_PREFIX, prefixSize) != 0)
+      continue;
+
+    uint32_t id = 0;
+    bool isNumber = true;
+    for (size_t i = prefixSize; i < component.value_size() && isNumber; i++) {
+      uint8_t c = component.value()[i];
+      isNumber = c >= '0' && c <= '9';
+      id = id * 10 + (c - '0');
+    }
+    if (isNumber) {
+      nodeId = id;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+NeighborDensity::GetOriginator(const ::ndn::Name& name, uint32_t& nodeId)
+{
+  // only beacons and bitmap Interests name their originator, as their first
+  // node<id> component
+  if (name.empty() || (name.get(0) != ::ndn::name::Component("beacon") &&
+                       name.get(0) != ::ndn::name::Component("bitmap")))
+    return false;
+  return GetNodeId(name, nodeId);
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,96 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_NEIGHBOR_DENSITY_HPP
+#define NTORRENT_NEIGHBOR_DENSITY_HPP
+
+#include <ndn-cxx/interest.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include "ns3/nstime.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Estimate of the number of neighbors of a node
+ *
+ * Beacons and bitmap Interests name their originator with a node<id>
+ * component. Every originator heard directly (not through a relay) during the
+ * last timeout counts as a neighbor.
+ */
+class NeighborDensity
+{
+public:
+  explicit
+  NeighborDensity(Time timeout = Seconds(5));
+
+  void
+  SetTimeout(Time timeout);
+
+  /**
+   * @brief record the originator of an Interest heard at time now, if it is a
+   * beacon or a bitmap Interest that has travelled a single hop
+   */
+  void
+  Observe(const ::ndn::Interest& interest, Time now);
+
+  /**
+   * @brief number of neighbors heard during the last timeout
+   */
+  uint32_t
+  GetCount(Time now);
+
+  /**
+   * @brief gossip rebroadcast probability, in percent, such that about
+   * target neighbors rebroadcast a packet: 100 * target / neighbors, but not
+   * below minProbability
+   */
+  uint32_t
+  GetForwardProbability(uint32_t target, uint32_t minProbability, Time now);
+
+  /**
+   * @brief find the node<id> component of a name
+   * @return false if the name has none
+   */
+  static bool
+  GetNodeId(const ::ndn::Name& name, uint32_t& nodeId);
+
+  /**
+   * @brief find the originator of a beacon or bitmap name
+   * @return false if the name is not a beacon or bitmap name with a node<id>
+   */
+  static bool
+  GetOriginator(const ::ndn::Name& name, uint32_t& nodeId);
+
+private:
+  // <node id, time last heard>
+  std::unordered_map<uint32_t, Time> m_neighbors;
+  Time m_timeout;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_NEIGHBOR_DENSITY_HPP
@@ -0,0 +1,94 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-overheard-table.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+OverheardTable::OverheardTable(Time lifetime)
+  : m_lifetime(lifetime)
+  , m_nextSweep(lifetime)
+{
+}
+
+void
+OverheardTable::SetLifetime(Time lifetime)
+{
+  m_lifetime = lifetime;
+}
+
+bool
+OverheardTable::Refresh(const std::string& prefix, Time now)
+{
+  Sweep(now);
+
+  auto entry = m_current.find(prefix);
+  if (entry == m_current.end()) {
+    entry = m_previous.find(prefix);
+    if (entry == m_previous.end())
+      return false;
+
+    // live entries move to the current generation
+    Time expiry = entry->second;
+    m_previous.erase(entry);
+    if (expiry <= now)
+      return false;
+    entry = m_current.emplace(prefix, expiry).first;
+  }
+
+  if (entry->second <= now) {
+    m_current.erase(entry);
+    return false;
+  }
+  entry->second = now + m_lifetime;
+  return true;
+}
+
+void
+OverheardTable::Insert(const std::string& prefix, Time now)
+{
+  Sweep(now);
+
+  m_previous.erase(prefix);
+  m_current[prefix] = now + m_lifetime;
+}
+
+void
+OverheardTable::Sweep(Time now)
+{
+  if (now < m_nextSweep)
+    return;
+
+  if (now >= m_nextSweep + m_lifetime) {
+    // nothing was heard for a whole generation, everything has expired
+    m_previous.clear();
+    m_current.clear();
+  }
+  else {
+    m_previous.swap(m_current);
+    m_current.clear();
+  }
+  m_nextSweep = now + m_lifetime;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,98 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_OVERHEARD_TABLE_HPP
+#define NTORRENT_OVERHEARD_TABLE_HPP
+
+#include "ns3/nstime.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Expiring hash table of overheard torrent prefixes
+ *
+ * Entries live in two generations of hash tables. Every lifetime the
+ * current generation becomes the previous one and the old previous
+ * generation is dropped, which can only drop expired entries. Lookups
+ * and insertions are O(1) and the table never holds more than the
+ * prefixes heard during the last two lifetimes.
+ */
+class OverheardTable
+{
+public:
+  explicit
+  OverheardTable(Time lifetime = MilliSeconds(200));
+
+  void
+  SetLifetime(Time lifetime);
+
+  Time
+  GetLifetime() const
+  {
+    return m_lifetime;
+  }
+
+  /**
+   * @brief check whether a prefix has been overheard and has not expired
+   *
+   * A live entry gets its expiration time refreshed, an expired one is removed.
+   */
+  bool
+  Refresh(const std::string& prefix, Time now);
+
+  /**
+   * @brief add (or refresh) a prefix overheard at time now
+   */
+  void
+  Insert(const std::string& prefix, Time now);
+
+  size_t
+  GetSize() const
+  {
+    return m_current.size() + m_previous.size();
+  }
+
+private:
+  /**
+   * @brief rotate the generations if a lifetime has passed since the last rotation
+   */
+  void
+  Sweep(Time now);
+
+private:
+  // <prefix, expiration time>
+  typedef std::unordered_map<std::string, Time> Generation;
+
+  Generation m_current;
+  Generation m_previous;
+
+  Time m_lifetime;
+  Time m_nextSweep;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_OVERHEARD_TABLE_HPP
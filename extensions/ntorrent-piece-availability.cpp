@@ -0,0 +1,107 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-availability.hpp"
+
+#include <cmath>
+
+namespace ns3 {
+namespace ndn {
+
+// weights stay below 2^MAX_WEIGHT_EXPONENT, far from the double range
+static const double MAX_WEIGHT_EXPONENT = 256;
+
+PieceAvailability::PieceAvailability(Time halfLife)
+  : m_halfLife(halfLife)
+{
+}
+
+void
+PieceAvailability::Reset(uint32_t numPieces)
+{
+  m_scores.assign(numPieces, 0);
+  m_epoch = Time();
+}
+
+void
+PieceAvailability::SetHalfLife(Time halfLife)
+{
+  m_halfLife = halfLife;
+}
+
+void
+PieceAvailability::Add(uint32_t seq, Time now)
+{
+  if (seq >= m_scores.size())
+    return;
+
+  if (m_halfLife.IsStrictlyPositive() &&
+      (now - m_epoch).GetSeconds() / m_halfLife.GetSeconds() > MAX_WEIGHT_EXPONENT) {
+    Rescale(now);
+  }
+  m_scores[seq] += GetWeight(now);
+}
+
+double
+PieceAvailability::GetScore(uint32_t seq, Time now) const
+{
+  if (seq >= m_scores.size())
+    return 0;
+  return m_scores[seq] / GetWeight(now);
+}
+
+uint32_t
+PieceAvailability::FindRarest(const PieceBitmap& have, const PieceBitmap& mine) const
+{
+  // all the scores are in the same unit, so they compare without decaying them
+  uint32_t rarest = PieceBitmap::NO_PIECE;
+  double rarestScore = 0;
+  have.ForEachMissing(mine, [&] (uint32_t seq) {
+      double score = seq < m_scores.size() ? m_scores[seq] : 0;
+      if (rarest == PieceBitmap::NO_PIECE || score < rarestScore) {
+        rarest = seq;
+        rarestScore = score;
+      }
+    });
+  return rarest;
+}
+
+double
+PieceAvailability::GetWeight(Time now) const
+{
+  // without decay, every observation weighs the same
+  if (!m_halfLife.IsStrictlyPositive())
+    return 1;
+  return std::exp2((now - m_epoch).GetSeconds() / m_halfLife.GetSeconds());
+}
+
+void
+PieceAvailability::Rescale(Time now)
+{
+  double weight = GetWeight(now);
+  for (double& score : m_scores) {
+    score /= weight;
+  }
+  m_epoch = now;
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,110 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_PIECE_AVAILABILITY_HPP
+#define NTORRENT_PIECE_AVAILABILITY_HPP
+
+#include "ntorrent-piece-bitmap.hpp"
+
+#include "ns3/nstime.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Decaying estimate of how many peers of the swarm hold each piece
+ *
+ * Every time a peer is found to hold a piece, the score of the piece grows
+ * by one, and scores halve every half-life. Decay is lazy: observations are
+ * weighted by 2^((now - epoch) / halfLife) instead of decaying all the stored
+ * scores, so that scores always compare in the same unit. When the weight
+ * grows too large all the scores are scaled down at once and the epoch moves
+ * to the current time.
+ */
+class PieceAvailability
+{
+public:
+  explicit
+  PieceAvailability(Time halfLife = Seconds(10));
+
+  /**
+   * @brief drop all the scores and size the index for numPieces pieces
+   */
+  void
+  Reset(uint32_t numPieces);
+
+  void
+  SetHalfLife(Time halfLife);
+
+  Time
+  GetHalfLife() const
+  {
+    return m_halfLife;
+  }
+
+  /**
+   * @brief record a peer holding the piece at time now
+   */
+  void
+  Add(uint32_t seq, Time now);
+
+  /**
+   * @brief decayed number of peers known to hold the piece at time now
+   */
+  double
+  GetScore(uint32_t seq, Time now) const;
+
+  /**
+   * @brief piece with the lowest score among those in have and not in mine
+   * (lowest sequence number on ties)
+   * @return the sequence number of the piece, or PieceBitmap::NO_PIECE
+   */
+  uint32_t
+  FindRarest(const PieceBitmap& have, const PieceBitmap& mine) const;
+
+private:
+  /**
+   * @brief weight of an observation at time now, relative to the epoch
+   */
+  double
+  GetWeight(Time now) const;
+
+  /**
+   * @brief move the epoch to now, scaling down all the scores
+   */
+  void
+  Rescale(Time now);
+
+private:
+  // scores in units of an observation at m_epoch
+  std::vector<double> m_scores;
+
+  Time m_halfLife;
+  Time m_epoch;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_PIECE_AVAILABILITY_HPP
@@ -0,0 +1,351 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-bitmap.hpp"
+#include "ntorrent-varint.hpp"
+
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+namespace ndn {
+
+const uint32_t PieceBitmap::NO_PIECE;
+const uint8_t PieceBitmap::COMPACT_VERSION;
+
+PieceBitmap::PieceBitmap()
+  : m_size(0)
+{
+}
+
+PieceBitmap::PieceBitmap(uint32_t numPieces)
+{
+  Resize(numPieces);
+}
+
+void
+PieceBitmap::Resize(uint32_t numPieces)
+{
+  m_size = numPieces;
+  m_words.assign((numPieces + 63) / 64, 0);
+}
+
+void
+PieceBitmap::SetAll()
+{
+  std::fill(m_words.begin(), m_words.end(), ~uint64_t(0));
+  ClearTail();
+}
+
+uint32_t
+PieceBitmap::Count() const
+{
+  uint32_t count = 0;
+  for (uint64_t word : m_words) {
+    count += __builtin_popcountll(word);
+  }
+  return count;
+}
+
+uint32_t
+PieceBitmap::CountMissing(const PieceBitmap& mine) const
+{
+  size_t nWords = std::min(m_words.size(), mine.m_words.size());
+  const uint64_t* have = m_words.data();
+  const uint64_t* own = mine.m_words.data();
+  uint32_t count = 0;
+  size_t i = 0;
+
+#ifdef __AVX2__
+  for (; i + 4 <= nWords; i += 4) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(have + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(own + i));
+    // andnot computes ~b & a
+    __m256i diff = _mm256_andnot_si256(b, a);
+    if (_mm256_testz_si256(diff, diff))
+      continue;
+    alignas(32) uint64_t words[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words), diff);
+    count += __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]) +
+             __builtin_popcountll(words[2]) + __builtin_popcountll(words[3]);
+  }
+#endif
+
+  for (; i < nWords; i++) {
+    count += __builtin_popcountll(have[i] & ~own[i]);
+  }
+  return count;
+}
+
+uint32_t
+PieceBitmap::FindFirstMissing(const PieceBitmap& mine, uint32_t from) const
+{
+  if (from >= m_size)
+    return NO_PIECE;
+
+  size_t nWords = std::min(m_words.size(), mine.m_words.size());
+  const uint64_t* have = m_words.data();
+  const uint64_t* own = mine.m_words.data();
+
+  // the first word is partially masked
+  size_t i = from / 64;
+  if (i >= nWords)
+    return NO_PIECE;
+  uint64_t word = have[i] & ~own[i] & (~uint64_t(0) << (from % 64));
+  if (word != 0)
+    return i * 64 + __builtin_ctzll(word);
+  i++;
+
+#ifdef __AVX2__
+  for (; i + 4 <= nWords; i += 4) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(have + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(own + i));
+    __m256i diff = _mm256_andnot_si256(b, a);
+    if (!_mm256_testz_si256(diff, diff))
+      break;
+  }
+#endif
+
+  for (; i < nWords; i++) {
+    word = have[i] & ~own[i];
+    if (word != 0)
+      return i * 64 + __builtin_ctzll(word);
+  }
+  return NO_PIECE;
+}
+
+// the wire encoding is the little-endian image of the words
+static inline uint64_t
+toLittleEndian(uint64_t word)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap64(word);
+#else
+  return word;
+#endif
+}
+
+void
+PieceBitmap::WireEncode(uint8_t* buffer) const
+{
+  size_t wireSize = GetWireSize();
+  size_t fullWords = wireSize / 8;
+  for (size_t i = 0; i < fullWords; i++) {
+    uint64_t word = toLittleEndian(m_words[i]);
+    std::memcpy(buffer + i * 8, &word, sizeof(word));
+  }
+  for (size_t i = fullWords * 8; i < wireSize; i++) {
+    buffer[i] = static_cast<uint8_t>(m_words[i / 8] >> (8 * (i % 8)));
+  }
+}
+
+bool
+PieceBitmap::WireDecode(const uint8_t* buffer, size_t size)
+{
+  if (size != GetWireSize())
+    return false;
+
+  // whole words are loaded straight from the buffer, the last partial
+  // word byte by byte
+  size_t fullWords = size / 8;
+  for (size_t i = 0; i < fullWords; i++) {
+    uint64_t word;
+    std::memcpy(&word, buffer + i * 8, sizeof(word));
+    m_words[i] = toLittleEndian(word);
+  }
+  if (fullWords < m_words.size()) {
+    uint64_t word = 0;
+    for (size_t i = fullWords * 8; i < size; i++) {
+      word |= uint64_t(buffer[i]) << (8 * (i % 8));
+    }
+    m_words[fullWords] = word;
+  }
+  ClearTail();
+  return true;
+}
+
+void
+PieceBitmap::EncodeCompact(std::vector<uint8_t>& wire) const
+{
+  // lengths of the alternating runs of missing and present pieces; the first
+  // (missing) run may be empty
+  std::vector<uint32_t> runs;
+  bool value = false;
+  for (uint32_t pos = 0; pos < m_size; value = !value) {
+    uint32_t next = FindNext(!value, pos);
+    runs.push_back(next - pos);
+    pos = next;
+  }
+
+  // payload size of each format. In the piece lists, the gap before the first
+  // piece of a run is the length of the previous run, and 0 inside a run
+  size_t sizes[4] = {GetWireSize(), 0, 0, 0};
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (i + 1 < runs.size())
+      sizes[COMPACT_RUNS] += varintSize(runs[i]);
+    if (runs[i] == 0)
+      continue;
+    size_t listSize = varintSize(i == 0 ? 0 : runs[i - 1]) + runs[i] - 1;
+    sizes[i % 2 == 0 ? COMPACT_MISSING : COMPACT_PRESENT] += listSize;
+  }
+
+  uint8_t format = COMPACT_RAW;
+  for (uint8_t f = COMPACT_RUNS; f <= COMPACT_MISSING; f++) {
+    if (sizes[f] < sizes[format])
+      format = f;
+  }
+
+  wire.clear();
+  wire.reserve(1 + varintSize(m_size) + sizes[format]);
+  wire.push_back(static_cast<uint8_t>(COMPACT_VERSION << 4 | format));
+  appendVarint(wire, m_size);
+
+  switch (format) {
+  case COMPACT_RAW: {
+    size_t offset = wire.size();
+    wire.resize(offset + sizes[COMPACT_RAW]);
+    WireEncode(wire.data() + offset);
+    break;
+  }
+  case COMPACT_RUNS:
+    for (size_t i = 0; i + 1 < runs.size(); i++) {
+      appendVarint(wire, runs[i]);
+    }
+    break;
+  default: {
+    // present pieces are the odd runs, missing pieces the even ones
+    size_t parity = (format == COMPACT_PRESENT) ? 1 : 0;
+    for (size_t i = parity; i < runs.size(); i += 2) {
+      if (runs[i] == 0)
+        continue;
+      appendVarint(wire, i == 0 ? 0 : runs[i - 1]);
+      wire.insert(wire.end(), runs[i] - 1, 0);
+    }
+    break;
+  }
+  }
+}
+
+bool
+PieceBitmap::DecodeCompact(const uint8_t* buffer, size_t size)
+{
+  const uint8_t* it = buffer;
+  const uint8_t* end = buffer + size;
+
+  if (size == 0 || (buffer[0] >> 4) != COMPACT_VERSION)
+    return false;
+  uint8_t format = buffer[0] & 0x0f;
+  it++;
+
+  uint32_t numPieces;
+  if (!readVarint(it, end, numPieces) || numPieces != m_size)
+    return false;
+
+  switch (format) {
+  case COMPACT_RAW:
+    return WireDecode(it, end - it);
+  case COMPACT_RUNS: {
+    std::fill(m_words.begin(), m_words.end(), 0);
+    uint32_t pos = 0;
+    bool value = false;
+    for (; it != end; value = !value) {
+      uint32_t length;
+      if (!readVarint(it, end, length) || length > m_size - pos)
+        return false;
+      if (value)
+        SetRange(pos, pos + length);
+      pos += length;
+    }
+    if (value)
+      SetRange(pos, m_size);
+    return true;
+  }
+  case COMPACT_PRESENT:
+  case COMPACT_MISSING: {
+    bool present = (format == COMPACT_PRESENT);
+    if (present)
+      std::fill(m_words.begin(), m_words.end(), 0);
+    else
+      SetAll();
+    uint64_t pos = 0;
+    while (it != end) {
+      uint32_t gap;
+      if (!readVarint(it, end, gap))
+        return false;
+      pos += gap;
+      if (pos >= m_size)
+        return false;
+      if (present)
+        Set(pos);
+      else
+        Reset(pos);
+      pos++;
+    }
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+uint32_t
+PieceBitmap::FindNext(bool value, uint32_t from) const
+{
+  if (from >= m_size)
+    return m_size;
+
+  // looking for a clear bit is looking for a set bit in the complement
+  uint64_t flip = value ? 0 : ~uint64_t(0);
+  size_t i = from / 64;
+  uint64_t word = (m_words[i] ^ flip) & (~uint64_t(0) << (from % 64));
+  while (word == 0) {
+    if (++i == m_words.size())
+      return m_size;
+    word = m_words[i] ^ flip;
+  }
+  // the complement of the tail bits is set, do not go past the last piece
+  return std::min<uint32_t>(i * 64 + __builtin_ctzll(word), m_size);
+}
+
+void
+PieceBitmap::SetRange(uint32_t from, uint32_t to)
+{
+  while (from < to) {
+    uint32_t bit = from % 64;
+    uint32_t n = std::min<uint32_t>(64 - bit, to - from);
+    uint64_t mask = (n == 64) ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    m_words[from / 64] |= mask << bit;
+    from += n;
+  }
+}
+
+void
+PieceBitmap::ClearTail()
+{
+  if (!m_words.empty())
+    m_words.back() &= WordMask(m_words.size() - 1);
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,256 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_PIECE_BITMAP_HPP
+#define NTORRENT_PIECE_BITMAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Bit-packed set of torrent pieces, 64 pieces per word
+ *
+ * The raw wire encoding is ceil(n / 8) bytes, piece i being bit (i % 8) of
+ * byte (i / 8). Bits past the last piece are always kept at zero, so whole
+ * word operations never see pieces that do not exist.
+ *
+ * The compact wire encoding is a header byte (version in the high nibble,
+ * format in the low nibble), the number of pieces as a varint and a payload
+ * in the smallest of the following formats:
+ *  - COMPACT_RAW: the raw wire encoding
+ *  - COMPACT_RUNS: varint lengths of alternating runs of missing and present
+ *    pieces, starting with missing pieces. The last run is implied
+ *  - COMPACT_PRESENT: varint gaps between consecutive present pieces
+ *  - COMPACT_MISSING: varint gaps between consecutive missing pieces
+ */
+class PieceBitmap
+{
+public:
+  static const uint32_t NO_PIECE = std::numeric_limits<uint32_t>::max();
+
+  static const uint8_t COMPACT_VERSION = 1;
+
+  enum CompactFormat {
+    COMPACT_RAW = 0,
+    COMPACT_RUNS = 1,
+    COMPACT_PRESENT = 2,
+    COMPACT_MISSING = 3
+  };
+
+  PieceBitmap();
+
+  explicit
+  PieceBitmap(uint32_t numPieces);
+
+  /**
+   * @brief resize the bitmap to numPieces pieces and clear all of them
+   */
+  void
+  Resize(uint32_t numPieces);
+
+  uint32_t
+  GetSize() const
+  {
+    return m_size;
+  }
+
+  void
+  Set(uint32_t seq)
+  {
+    if (seq < m_size)
+      m_words[seq / 64] |= uint64_t(1) << (seq % 64);
+  }
+
+  void
+  Reset(uint32_t seq)
+  {
+    if (seq < m_size)
+      m_words[seq / 64] &= ~(uint64_t(1) << (seq % 64));
+  }
+
+  bool
+  Test(uint32_t seq) const
+  {
+    return seq < m_size && ((m_words[seq / 64] >> (seq % 64)) & 1) != 0;
+  }
+
+  void
+  SetAll();
+
+  /**
+   * @brief number of pieces in the set
+   */
+  uint32_t
+  Count() const;
+
+  /**
+   * @brief number of pieces in this set that are not in mine (popcount of have & ~mine)
+   */
+  uint32_t
+  CountMissing(const PieceBitmap& mine) const;
+
+  /**
+   * @brief first piece at or after from that is in this set and not in mine
+   * @return the sequence number of the piece, or NO_PIECE
+   */
+  uint32_t
+  FindFirstMissing(const PieceBitmap& mine, uint32_t from = 0) const;
+
+  /**
+   * @brief call f(seq) for every piece in the set
+   */
+  template<typename F>
+  void
+  ForEachSet(F f) const
+  {
+    for (size_t i = 0; i < m_words.size(); i++) {
+      uint64_t word = m_words[i];
+      while (word != 0) {
+        f(static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+        word &= word - 1;
+      }
+    }
+  }
+
+  /**
+   * @brief call f(seq) for every piece that is in this set and not in mine
+   */
+  template<typename F>
+  void
+  ForEachMissing(const PieceBitmap& mine, F f) const
+  {
+    ForEachSetBit(mine, [] (uint64_t a, uint64_t b) { return a & ~b; }, f);
+  }
+
+  /**
+   * @brief call f(seq) for every piece that is neither in this set nor in other
+   */
+  template<typename F>
+  void
+  ForEachMissingInBoth(const PieceBitmap& other, F f) const
+  {
+    ForEachSetBit(other, [] (uint64_t a, uint64_t b) { return ~a & ~b; }, f);
+  }
+
+  /**
+   * @brief size in bytes of the wire encoding
+   */
+  size_t
+  GetWireSize() const
+  {
+    return (m_size + 7) / 8;
+  }
+
+  /**
+   * @brief write the wire encoding into buffer (GetWireSize() bytes)
+   */
+  void
+  WireEncode(uint8_t* buffer) const;
+
+  /**
+   * @brief replace the content with a wire encoded bitmap of the same size
+   * @return false if the encoding does not match the size of the bitmap
+   */
+  bool
+  WireDecode(const uint8_t* buffer, size_t size);
+
+  /**
+   * @brief replace wire with the compact encoding of the bitmap
+   */
+  void
+  EncodeCompact(std::vector<uint8_t>& wire) const;
+
+  /**
+   * @brief replace the content with a compact encoded bitmap of the same size
+   * @return false if the encoding is malformed or does not match the size of
+   *         the bitmap, in which case the content is unspecified
+   */
+  bool
+  DecodeCompact(const uint8_t* buffer, size_t size);
+
+  bool
+  operator==(const PieceBitmap& other) const
+  {
+    return m_size == other.m_size && m_words == other.m_words;
+  }
+
+  bool
+  operator!=(const PieceBitmap& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  template<typename Op, typename F>
+  void
+  ForEachSetBit(const PieceBitmap& other, Op op, F f) const
+  {
+    size_t nWords = std::min(m_words.size(), other.m_words.size());
+    for (size_t i = 0; i < nWords; i++) {
+      uint64_t word = op(m_words[i], other.m_words[i]) & WordMask(i);
+      while (word != 0) {
+        f(static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+        word &= word - 1;
+      }
+    }
+  }
+
+  /**
+   * @brief mask of the valid piece bits of word i
+   */
+  uint64_t
+  WordMask(size_t i) const
+  {
+    uint32_t tail = m_size - i * 64;
+    return tail >= 64 ? ~uint64_t(0) : (uint64_t(1) << tail) - 1;
+  }
+
+  void
+  ClearTail();
+
+  /**
+   * @brief first piece at or after from whose bit equals value
+   * @return the sequence number of the piece, or GetSize()
+   */
+  uint32_t
+  FindNext(bool value, uint32_t from) const;
+
+  /**
+   * @brief set the pieces in [from, to)
+   */
+  void
+  SetRange(uint32_t from, uint32_t to);
+
+private:
+  std::vector<uint64_t> m_words;
+  uint32_t m_size;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_PIECE_BITMAP_HPP
@@ -0,0 +1,314 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-scarcity.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+const uint32_t PieceScarcity::NO_PIECE;
+
+PieceScarcity::PieceScarcity()
+  : m_headBucket(NO_PIECE)
+  , m_tailBucket(NO_PIECE)
+  , m_size(0)
+  , m_leaves(1)
+{
+}
+
+void
+PieceScarcity::Reset(uint32_t numPieces)
+{
+  m_pieces.assign(numPieces, Piece{NO_PIECE, NO_PIECE, NO_PIECE});
+  m_isPending.assign(numPieces, false);
+  m_buckets.clear();
+  m_freeBuckets.clear();
+  m_headBucket = NO_PIECE;
+  m_tailBucket = NO_PIECE;
+  m_size = 0;
+
+  m_neighbors.clear();
+  m_leaves = 1;
+  while (m_leaves < numPieces)
+    m_leaves *= 2;
+}
+
+void
+PieceScarcity::Insert(uint32_t seq)
+{
+  if (Contains(seq))
+    return;
+
+  // new pieces always go to the lowest counter bucket
+  uint32_t bucket = m_headBucket;
+  if (bucket == NO_PIECE || m_buckets[bucket].count != 1) {
+    bucket = AllocateBucket(1);
+    LinkBucketAfter(bucket, NO_PIECE);
+  }
+  AppendToBucket(seq, bucket);
+  m_size++;
+  UpdateNeighbors(seq);
+}
+
+void
+PieceScarcity::Erase(uint32_t seq)
+{
+  if (!Contains(seq))
+    return;
+
+  RemoveFromBucket(seq);
+  m_isPending[seq] = false;
+  m_size--;
+  UpdateNeighbors(seq);
+}
+
+void
+PieceScarcity::Increment(uint32_t seq)
+{
+  if (!Contains(seq))
+    return;
+
+  MoveUp(seq);
+  UpdateNeighbors(seq);
+}
+
+void
+PieceScarcity::IncrementAll(const std::vector<uint32_t>& seqs)
+{
+  uint32_t nChanged = 0;
+  for (uint32_t seq : seqs) {
+    if (Contains(seq)) {
+      MoveUp(seq);
+      nChanged++;
+    }
+  }
+
+  // per piece, an update costs O(log N) per neighbor that has the piece, and
+  // a rebuild costs O(N) per neighbor
+  uint32_t depth = 1;
+  for (uint32_t leaves = m_leaves; leaves > 1; leaves /= 2)
+    depth++;
+  if (static_cast<uint64_t>(nChanged) * depth < m_leaves) {
+    for (uint32_t seq : seqs) {
+      if (Contains(seq))
+        UpdateNeighbors(seq);
+    }
+  }
+  else {
+    for (auto& neighbor : m_neighbors) {
+      RebuildTree(neighbor.second.tree, neighbor.second.bitmap);
+    }
+  }
+}
+
+void
+PieceScarcity::MoveUp(uint32_t seq)
+{
+  uint32_t current = m_pieces[seq].bucket;
+  uint32_t count = m_buckets[current].count + 1;
+
+  // the piece moves to the adjacent bucket, creating it if needed
+  uint32_t target = m_buckets[current].next;
+  if (target == NO_PIECE || m_buckets[target].count != count) {
+    target = AllocateBucket(count);
+    LinkBucketAfter(target, current);
+  }
+  RemoveFromBucket(seq);
+  AppendToBucket(seq, target);
+}
+
+bool
+PieceScarcity::Contains(uint32_t seq) const
+{
+  return seq < m_pieces.size() && m_pieces[seq].bucket != NO_PIECE;
+}
+
+uint32_t
+PieceScarcity::GetCount(uint32_t seq) const
+{
+  if (!Contains(seq))
+    return 0;
+  return m_buckets[m_pieces[seq].bucket].count;
+}
+
+void
+PieceScarcity::SetPending(uint32_t seq, bool isPending)
+{
+  if (!Contains(seq) || m_isPending[seq] == isPending)
+    return;
+
+  m_isPending[seq] = isPending;
+  UpdateNeighbors(seq);
+}
+
+void
+PieceScarcity::UpdateNeighbor(uint32_t nodeId, const PieceBitmap& bitmap)
+{
+  Neighbor& neighbor = m_neighbors[nodeId];
+  neighbor.bitmap = bitmap;
+  RebuildTree(neighbor.tree, neighbor.bitmap);
+}
+
+void
+PieceScarcity::RebuildTree(std::vector<uint32_t>& tree, const PieceBitmap& bitmap) const
+{
+  tree.assign(2 * m_leaves, 0);
+
+  uint32_t numPieces = std::min<uint32_t>(bitmap.GetSize(), m_pieces.size());
+  for (uint32_t seq = 0; seq < numPieces; seq++) {
+    if (bitmap.Test(seq))
+      tree[m_leaves + seq] = GetRank(seq);
+  }
+  for (uint32_t i = m_leaves - 1; i > 0; i--) {
+    tree[i] = std::max(tree[2 * i], tree[2 * i + 1]);
+  }
+}
+
+void
+PieceScarcity::EraseNeighbor(uint32_t nodeId)
+{
+  m_neighbors.erase(nodeId);
+}
+
+uint32_t
+PieceScarcity::FindRarestFrom(uint32_t nodeId) const
+{
+  auto neighbor = m_neighbors.find(nodeId);
+  if (neighbor == m_neighbors.end() || neighbor->second.tree[1] == 0)
+    return NO_PIECE;
+
+  // follow the maximum down to its leftmost leaf
+  const std::vector<uint32_t>& tree = neighbor->second.tree;
+  uint32_t i = 1;
+  while (i < m_leaves) {
+    i = (tree[2 * i] == tree[i]) ? 2 * i : 2 * i + 1;
+  }
+  return i - m_leaves;
+}
+
+void
+PieceScarcity::UpdateNeighbors(uint32_t seq)
+{
+  uint32_t rank = GetRank(seq);
+  for (auto& neighbor : m_neighbors) {
+    if (!neighbor.second.bitmap.Test(seq))
+      continue;
+
+    std::vector<uint32_t>& tree = neighbor.second.tree;
+    uint32_t i = m_leaves + seq;
+    tree[i] = rank;
+    for (i /= 2; i > 0; i /= 2) {
+      tree[i] = std::max(tree[2 * i], tree[2 * i + 1]);
+    }
+  }
+}
+
+uint32_t
+PieceScarcity::AllocateBucket(uint32_t count)
+{
+  uint32_t bucket;
+  if (!m_freeBuckets.empty()) {
+    bucket = m_freeBuckets.back();
+    m_freeBuckets.pop_back();
+  }
+  else {
+    bucket = m_buckets.size();
+    m_buckets.push_back(Bucket());
+  }
+  m_buckets[bucket] = Bucket{count, NO_PIECE, NO_PIECE, NO_PIECE, NO_PIECE};
+  return bucket;
+}
+
+void
+PieceScarcity::LinkBucketAfter(uint32_t bucket, uint32_t after)
+{
+  // after == NO_PIECE links the bucket in front of the list
+  uint32_t next = (after == NO_PIECE) ? m_headBucket : m_buckets[after].next;
+
+  m_buckets[bucket].prev = after;
+  m_buckets[bucket].next = next;
+
+  if (after == NO_PIECE)
+    m_headBucket = bucket;
+  else
+    m_buckets[after].next = bucket;
+
+  if (next == NO_PIECE)
+    m_tailBucket = bucket;
+  else
+    m_buckets[next].prev = bucket;
+}
+
+void
+PieceScarcity::UnlinkBucket(uint32_t bucket)
+{
+  uint32_t prev = m_buckets[bucket].prev;
+  uint32_t next = m_buckets[bucket].next;
+
+  if (prev == NO_PIECE)
+    m_headBucket = next;
+  else
+    m_buckets[prev].next = next;
+
+  if (next == NO_PIECE)
+    m_tailBucket = prev;
+  else
+    m_buckets[next].prev = prev;
+
+  m_freeBuckets.push_back(bucket);
+}
+
+void
+PieceScarcity::AppendToBucket(uint32_t seq, uint32_t bucket)
+{
+  Bucket& b = m_buckets[bucket];
+  m_pieces[seq] = Piece{bucket, b.tail, NO_PIECE};
+  if (b.tail == NO_PIECE)
+    b.head = seq;
+  else
+    m_pieces[b.tail].next = seq;
+  b.tail = seq;
+}
+
+void
+PieceScarcity::RemoveFromBucket(uint32_t seq)
+{
+  Piece& p = m_pieces[seq];
+  Bucket& b = m_buckets[p.bucket];
+
+  if (p.prev == NO_PIECE)
+    b.head = p.next;
+  else
+    m_pieces[p.prev].next = p.next;
+
+  if (p.next == NO_PIECE)
+    b.tail = p.prev;
+  else
+    m_pieces[p.next].prev = p.prev;
+
+  if (b.head == NO_PIECE)
+    UnlinkBucket(p.bucket);
+
+  p = Piece{NO_PIECE, NO_PIECE, NO_PIECE};
+}
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,239 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_PIECE_SCARCITY_HPP
+#define NTORRENT_PIECE_SCARCITY_HPP
+
+#include "ntorrent-piece-bitmap.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Rarity index over the torrent pieces a peer is still missing
+ *
+ * Every tracked piece has a counter (the number of peers known to be missing
+ * it as well, plus one). Pieces are kept in buckets of equal counter value and
+ * the non-empty buckets form a list ordered by counter, so that a counter can
+ * only move to the adjacent bucket. FindRarest visits pieces from the highest
+ * counter downwards, stopping at the first piece accepted by the caller.
+ *
+ * The pieces every neighbor has are indexed as well, in a max segment tree
+ * over the counters of its tracked pieces that are not pending, so that
+ * FindRarestFrom answers in O(log N). Insert, Erase, Increment and SetPending
+ * then cost O(log N) per neighbor that has the piece, and UpdateNeighbor
+ * rebuilds the tree of a neighbor in O(N). IncrementAll, for the counters
+ * changed by a bitmap, updates the trees piece by piece or rebuilds them,
+ * whichever is cheaper, so that it costs at most O(N) per neighbor.
+ */
+class PieceScarcity
+{
+public:
+  static const uint32_t NO_PIECE = std::numeric_limits<uint32_t>::max();
+
+  PieceScarcity();
+
+  /**
+   * @brief drop all the tracked pieces and size the index for numPieces pieces
+   */
+  void
+  Reset(uint32_t numPieces);
+
+  /**
+   * @brief start tracking a piece with a counter of 1
+   */
+  void
+  Insert(uint32_t seq);
+
+  /**
+   * @brief stop tracking a piece (no-op if the piece is not tracked)
+   */
+  void
+  Erase(uint32_t seq);
+
+  /**
+   * @brief add 1 to the counter of a tracked piece
+   */
+  void
+  Increment(uint32_t seq);
+
+  /**
+   * @brief add 1 to the counters of the tracked pieces among seqs
+   */
+  void
+  IncrementAll(const std::vector<uint32_t>& seqs);
+
+  bool
+  Contains(uint32_t seq) const;
+
+  uint32_t
+  GetCount(uint32_t seq) const;
+
+  /**
+   * @brief mark a tracked piece as requested, FindRarestFrom skipping it, or not
+   */
+  void
+  SetPending(uint32_t seq, bool isPending);
+
+  bool
+  IsPending(uint32_t seq) const
+  {
+    return Contains(seq) && m_isPending[seq];
+  }
+
+  /**
+   * @brief index the pieces of a neighbor, replacing its previous bitmap
+   */
+  void
+  UpdateNeighbor(uint32_t nodeId, const PieceBitmap& bitmap);
+
+  void
+  EraseNeighbor(uint32_t nodeId);
+
+  /**
+   * @brief find the piece with the highest counter that the neighbor has and
+   *        that is not pending, the lowest sequence number among equals
+   * @return the sequence number of the piece, or NO_PIECE if there is none
+   */
+  uint32_t
+  FindRarestFrom(uint32_t nodeId) const;
+
+  uint32_t
+  GetSize() const
+  {
+    return m_size;
+  }
+
+  bool
+  IsEmpty() const
+  {
+    return m_size == 0;
+  }
+
+  /**
+   * @brief find the piece with the highest counter for which accept(seq) is true
+   * @return the sequence number of the piece, or NO_PIECE if none is accepted
+   */
+  template<typename Predicate>
+  uint32_t
+  FindRarest(Predicate accept) const
+  {
+    for (uint32_t b = m_tailBucket; b != NO_PIECE; b = m_buckets[b].prev) {
+      for (uint32_t seq = m_buckets[b].head; seq != NO_PIECE; seq = m_pieces[seq].next) {
+        if (accept(seq))
+          return seq;
+      }
+    }
+    return NO_PIECE;
+  }
+
+private:
+  uint32_t
+  AllocateBucket(uint32_t count);
+
+  void
+  LinkBucketAfter(uint32_t bucket, uint32_t after);
+
+  void
+  UnlinkBucket(uint32_t bucket);
+
+  void
+  AppendToBucket(uint32_t seq, uint32_t bucket);
+
+  void
+  RemoveFromBucket(uint32_t seq);
+
+  /**
+   * @brief value of the leaf of a piece in the tree of a neighbor that has it
+   */
+  uint32_t
+  GetRank(uint32_t seq) const
+  {
+    return Contains(seq) && !m_isPending[seq] ? GetCount(seq) : 0;
+  }
+
+  /**
+   * @brief refresh the leaf of a piece in the trees of the neighbors that have it
+   */
+  void
+  UpdateNeighbors(uint32_t seq);
+
+  /**
+   * @brief rebuild the tree of a neighbor from its bitmap in O(N)
+   */
+  void
+  RebuildTree(std::vector<uint32_t>& tree, const PieceBitmap& bitmap) const;
+
+  /**
+   * @brief move a tracked piece to the next counter bucket, leaving the trees
+   */
+  void
+  MoveUp(uint32_t seq);
+
+private:
+  struct Piece
+  {
+    uint32_t bucket; // NO_PIECE if the piece is not tracked
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  struct Bucket
+  {
+    uint32_t count;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t prev; // bucket with the next lower counter
+    uint32_t next; // bucket with the next higher counter
+  };
+
+  struct Neighbor
+  {
+    PieceBitmap bitmap;
+    // tree[1] is the root, tree[m_leaves + seq] the leaf of piece seq
+    std::vector<uint32_t> tree;
+  };
+
+  std::vector<Piece> m_pieces;
+  std::vector<bool> m_isPending;
+  std::vector<Bucket> m_buckets;
+  std::vector<uint32_t> m_freeBuckets;
+
+  // lowest and highest counter buckets
+  uint32_t m_headBucket;
+  uint32_t m_tailBucket;
+
+  uint32_t m_size;
+
+  std::unordered_map<uint32_t, Neighbor> m_neighbors;
+  // number of leaves of the trees, a power of two
+  uint32_t m_leaves;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_PIECE_SCARCITY_HPP
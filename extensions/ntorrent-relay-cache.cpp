@@ -0,0 +1,80 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-relay-cache.hpp"
+
+namespace ns3 {
+namespace ndn {
+
+RelayCache::RelayCache(size_t capacity)
+  : m_capacity(capacity)
+  , m_clock(0)
+{
+}
+
+void
+RelayCache::SetCapacity(size_t capacity)
+{
+  m_capacity = capacity;
+  Evict();
+}
+
+void
+RelayCache::Insert(std::shared_ptr<const ::ndn::Data> data)
+{
+  if (m_capacity == 0 || m_entries.count(data->getName()) != 0)
+    return;
+
+  // admit at the lowest key, as the newest piece among those with that key
+  uint64_t key = m_ranks.empty() ? 0 : m_ranks.begin()->first.first;
+  Rank rank(key, m_clock++);
+  m_entries.emplace(data->getName(), Entry{data, rank});
+  m_ranks.emplace(rank, data->getName());
+  Evict();
+}
+
+std::shared_ptr<const ::ndn::Data>
+RelayCache::Find(const ::ndn::Name& name)
+{
+  auto entry = m_entries.find(name);
+  if (entry == m_entries.end())
+    return nullptr;
+
+  // move the piece up the eviction order
+  Rank& rank = entry->second.rank;
+  m_ranks.erase(rank);
+  rank = Rank(rank.first + 1, m_clock++);
+  m_ranks.emplace(rank, name);
+  return entry->second.data;
+}
+
+void
+RelayCache::Evict()
+{
+  while (m_entries.size() > m_capacity) {
+    auto victim = m_ranks.begin();
+    m_entries.erase(victim->second);
+    m_ranks.erase(victim);
+  }
+}
+
+} // namespace ndn
+} // namespace ns3
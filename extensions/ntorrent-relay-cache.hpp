@@ -0,0 +1,104 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_RELAY_CACHE_HPP
+#define NTORRENT_RELAY_CACHE_HPP
+
+#include <ndn-cxx/data.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace ns3 {
+namespace ndn {
+
+/**
+ * @brief Bounded cache of the torrent pieces relayed by a forwarder
+ *
+ * Every piece has a frequency key, incremented by every Interest it answers.
+ * When the cache is full the piece with the lowest key is evicted, the least
+ * recently used one among those with the same key. A new piece is admitted at
+ * the lowest key in the cache rather than at zero (dynamic aging, as in
+ * LFU-DA), so that it is not the next victim once all the pieces have been
+ * hit, and pieces that were popular long ago age out. A capacity of 0
+ * disables the cache.
+ */
+class RelayCache
+{
+public:
+  explicit
+  RelayCache(size_t capacity = 100);
+
+  void
+  SetCapacity(size_t capacity);
+
+  size_t
+  GetCapacity() const
+  {
+    return m_capacity;
+  }
+
+  size_t
+  GetSize() const
+  {
+    return m_entries.size();
+  }
+
+  /**
+   * @brief add a piece (no-op if it is already cached)
+   */
+  void
+  Insert(std::shared_ptr<const ::ndn::Data> data);
+
+  /**
+   * @brief find the piece of an Interest name, counting a hit
+   * @return the piece, or nullptr if it is not cached
+   */
+  std::shared_ptr<const ::ndn::Data>
+  Find(const ::ndn::Name& name);
+
+private:
+  void
+  Evict();
+
+private:
+  // <frequency key, last use>, ordered from the first piece to evict
+  typedef std::pair<uint64_t, uint64_t> Rank;
+
+  struct Entry
+  {
+    std::shared_ptr<const ::ndn::Data> data;
+    Rank rank;
+  };
+
+  size_t m_capacity;
+  std::unordered_map<::ndn::Name, Entry> m_entries;
+  std::map<Rank, ::ndn::Name> m_ranks;
+  // logical clock of the insertions and hits
+  uint64_t m_clock;
+};
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_RELAY_CACHE_HPP
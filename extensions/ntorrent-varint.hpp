@@ -0,0 +1,73 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#ifndef NTORRENT_VARINT_HPP
+#define NTORRENT_VARINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+namespace ndn {
+
+// Unsigned LEB128 varints (7 bits per byte, least significant group first)
+// used by the compact bitmap encodings
+
+inline size_t
+varintSize(uint32_t value)
+{
+  size_t size = 1;
+  for (; value >= 0x80; value >>= 7) {
+    size++;
+  }
+  return size;
+}
+
+inline void
+appendVarint(std::vector<uint8_t>& wire, uint32_t value)
+{
+  for (; value >= 0x80; value >>= 7) {
+    wire.push_back(static_cast<uint8_t>(value | 0x80));
+  }
+  wire.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool
+readVarint(const uint8_t*& it, const uint8_t* end, uint32_t& value)
+{
+  value = 0;
+  for (int shift = 0; it != end; shift += 7) {
+    uint8_t byte = *it++;
+    // at most 5 bytes, the last one holding the 4 upper bits
+    if (shift == 28 && byte > 0x0f)
+      return false;
+    value |= uint32_t(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+} // namespace ndn
+} // namespace ns3
+
+#endif // NTORRENT_VARINT_HPP
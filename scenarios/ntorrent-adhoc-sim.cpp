@@ -80,6 +80,10 @@ main(int argc, char *argv[])
   uint32_t speedMax = 10;
   std::string numPackets = "10";
   uint32_t prngSeed = 1;
+  // pacing of the Data sent by the forwarders, 0bps for no pacing
+  std::string pacingRate = "0bps";
+  uint32_t pacingBurst = 4400;
+  uint32_t pacingQueueSize = 50;
 
   // Read optional command-line parameters (e.g., enable visualizer with ./waf --run=<> --visualize
   CommandLine cmd;
@@ -89,8 +93,15 @@ main(int argc, char *argv[])
   cmd.AddValue("speedMax", "Maximum speed (m/s)", speedMax);
   cmd.AddValue("numPackets", "Number of Packets", numPackets);
   cmd.AddValue("prngSeed", "PRNG Seed", prngSeed);
+  cmd.AddValue("pacingRate", "Pacing rate of the Data sent on every face", pacingRate);
+  cmd.AddValue("pacingBurst", "Bytes of Data a face may send back to back", pacingBurst);
+  cmd.AddValue("pacingQueueSize", "Number of Data packets waiting for a face", pacingQueueSize);
   cmd.Parse(argc, argv);
 
+  GlobalValue::Bind("TrafficManagerRate", DataRateValue(DataRate(pacingRate)));
+  GlobalValue::Bind("TrafficManagerBurst", UintegerValue(pacingBurst));
+  GlobalValue::Bind("TrafficManagerQueueSize", UintegerValue(pacingQueueSize));
+
   ns3::RngSeedManager::SetSeed(prngSeed);
 
   // Creating nodes
@@ -56,12 +56,14 @@ main(int argc, char *argv[])
   uint32_t namesPerSegment = 2;
   uint32_t namesPerManifest = 2;
   uint32_t dataPacketSize = 64;
+  std::string strategy = "/localhost/nfd/strategy/multicast";
   
   // Read optional command-line parameters (e.g., enable visualizer with ./waf --run=<> --visualize
   CommandLine cmd;
   cmd.AddValue("namesPerSegment", "Number of names per segment", namesPerSegment);
   cmd.AddValue("namesPerManifest", "Number of names per manifest", namesPerManifest);
   cmd.AddValue("dataPacketSize", "Data Packet size", dataPacketSize);
+  cmd.AddValue("strategy", "Forwarding strategy", strategy);
   cmd.Parse(argc, argv);
 
   int nodeCount = 10;
@@ -93,7 +95,7 @@ main(int argc, char *argv[])
   ndnHelper.InstallAll();
 
   // Choosing forwarding strategy
-  StrategyChoiceHelper::InstallAll("/", "/localhost/nfd/strategy/multicast");
+  StrategyChoiceHelper::InstallAll("/", strategy);
 
   GlobalRoutingHelper ndnGlobalRoutingHelper;
   ndnGlobalRoutingHelper.InstallAll();
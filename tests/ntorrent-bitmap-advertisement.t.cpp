@@ -0,0 +1,110 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-bitmap-advertisement.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestBitmapAdvertisement)
+
+BOOST_AUTO_TEST_CASE(FullRoundTrip)
+{
+  PieceBitmap bitmap(300);
+  for (uint32_t seq = 0; seq < 300; seq += 7) {
+    bitmap.Set(seq);
+  }
+
+  BitmapAdvertisement advertisement;
+  advertisement.sender = 12;
+  advertisement.version = 44;
+  advertisement.acks = {{3, 5}, {200, 1000}};
+  std::vector<uint8_t> wire;
+  advertisement.WireEncodeFull(bitmap, wire);
+
+  BitmapAdvertisement decoded;
+  BOOST_REQUIRE(decoded.WireDecode(wire.data(), wire.size()));
+  BOOST_CHECK_EQUAL(decoded.sender, 12);
+  BOOST_CHECK_EQUAL(decoded.version, 44);
+  BOOST_CHECK_EQUAL(decoded.base, 0);
+  BOOST_CHECK_EQUAL(decoded.GetAck(3), 5);
+  BOOST_CHECK_EQUAL(decoded.GetAck(200), 1000);
+  BOOST_CHECK_EQUAL(decoded.GetAck(4), 0);
+
+  PieceBitmap applied(300);
+  applied.Set(1);
+  BOOST_REQUIRE(decoded.Apply(applied));
+  BOOST_CHECK(applied == bitmap);
+}
+
+BOOST_AUTO_TEST_CASE(DeltaRoundTrip)
+{
+  BitmapAdvertisement advertisement;
+  advertisement.sender = 7;
+  advertisement.version = 10;
+  advertisement.base = 7;
+  const uint32_t gained[] = {0, 128, 299};
+  std::vector<uint8_t> wire;
+  advertisement.WireEncodeDelta(gained, 3, wire);
+
+  BitmapAdvertisement decoded;
+  BOOST_REQUIRE(decoded.WireDecode(wire.data(), wire.size()));
+  BOOST_CHECK_EQUAL(decoded.base, 7);
+  BOOST_CHECK(decoded.acks.empty());
+
+  // the gained pieces are added to the bitmap known at the base version
+  PieceBitmap bitmap(300);
+  bitmap.Set(5);
+  BOOST_REQUIRE(decoded.Apply(bitmap));
+  BOOST_CHECK_EQUAL(bitmap.Count(), 4);
+  BOOST_CHECK(bitmap.Test(0) && bitmap.Test(5) && bitmap.Test(128) && bitmap.Test(299));
+
+  // a gained piece past the end of the bitmap is malformed
+  PieceBitmap small(100);
+  BOOST_CHECK(!decoded.Apply(small));
+}
+
+BOOST_AUTO_TEST_CASE(Malformed)
+{
+  BitmapAdvertisement advertisement;
+  advertisement.version = 3;
+  advertisement.base = 2;
+  advertisement.acks = {{1, 1}};
+  std::vector<uint8_t> wire;
+  advertisement.WireEncodeDelta(nullptr, 0, wire);
+
+  BitmapAdvertisement decoded;
+  BOOST_CHECK(decoded.WireDecode(wire.data(), wire.size()));
+  // truncated in the acks
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), wire.size() - 1));
+
+  // a delta cannot go backwards
+  advertisement.version = 1;
+  advertisement.WireEncodeDelta(nullptr, 0, wire);
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), wire.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
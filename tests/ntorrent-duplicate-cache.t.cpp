@@ -0,0 +1,87 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-duplicate-cache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestDuplicateCache)
+
+static ::ndn::Data
+makeData(const ::ndn::Name& name)
+{
+  ::ndn::Data data(name);
+  ::ndn::Signature signature(::ndn::SignatureInfo(::ndn::tlv::DigestSha256));
+  signature.setValue(::ndn::makeNonNegativeIntegerBlock(::ndn::tlv::SignatureValue, 0));
+  data.setSignature(signature);
+  return data;
+}
+
+BOOST_AUTO_TEST_CASE(Fifo)
+{
+  DuplicateCache cache(3);
+  BOOST_CHECK(cache.Insert(1));
+  BOOST_CHECK(!cache.Insert(1));
+  BOOST_CHECK(cache.Insert(2));
+  BOOST_CHECK(cache.Insert(3));
+  BOOST_CHECK_EQUAL(cache.GetSize(), 3);
+
+  // the oldest key goes first
+  BOOST_CHECK(cache.Insert(4));
+  BOOST_CHECK(!cache.Contains(1));
+  BOOST_CHECK(cache.Contains(2));
+  BOOST_CHECK(cache.Contains(4));
+
+  cache.SetCapacity(1);
+  BOOST_CHECK_EQUAL(cache.GetSize(), 1);
+  BOOST_CHECK(cache.Contains(4));
+}
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  DuplicateCache cache(0);
+  BOOST_CHECK(cache.Insert(1));
+  BOOST_CHECK(cache.Insert(1));
+  BOOST_CHECK_EQUAL(cache.GetSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Keys)
+{
+  ::ndn::Interest interest(::ndn::Name("/movie1/node1"));
+  interest.setNonce(1);
+  ::ndn::Interest copy(interest);
+  ::ndn::Interest otherNonce(interest);
+  otherNonce.setNonce(2);
+  BOOST_CHECK_EQUAL(DuplicateCache::GetKey(interest), DuplicateCache::GetKey(copy));
+  BOOST_CHECK_NE(DuplicateCache::GetKey(interest), DuplicateCache::GetKey(otherNonce));
+
+  ::ndn::Data data = makeData("/movie1/%00%01");
+  BOOST_CHECK_EQUAL(DuplicateCache::GetKey(data), DuplicateCache::GetKey(makeData("/movie1/%00%01")));
+  BOOST_CHECK_NE(DuplicateCache::GetKey(data), DuplicateCache::GetKey(makeData("/movie1/%00%02")));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,197 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-ibf.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestIbf)
+
+static std::vector<uint32_t>
+sorted(std::vector<uint32_t> keys)
+{
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+BOOST_AUTO_TEST_CASE(InsertErase)
+{
+  InvertibleBloomFilter ibf(30);
+  BOOST_CHECK_EQUAL(ibf.GetSize() % InvertibleBloomFilter::N_HASHES, 0);
+  for (uint32_t key = 0; key < 100; key++) {
+    ibf.Insert(key);
+  }
+  for (uint32_t key = 0; key < 100; key++) {
+    ibf.Erase(key);
+  }
+  for (uint32_t i = 0; i < ibf.GetSize(); i++) {
+    BOOST_CHECK(ibf.GetCell(i).IsEmpty());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PeelDifference)
+{
+  InvertibleBloomFilter ours(60);
+  InvertibleBloomFilter theirs(60);
+  std::vector<uint32_t> onlyOurs;
+  std::vector<uint32_t> onlyTheirs;
+  for (uint32_t key = 0; key < 1000; key++) {
+    ours.Insert(key);
+    if (key % 100 == 7)
+      onlyOurs.push_back(key);
+    else
+      theirs.Insert(key);
+  }
+  for (uint32_t key = 5000; key < 5005; key++) {
+    theirs.Insert(key);
+    onlyTheirs.push_back(key);
+  }
+
+  BOOST_CHECK(ours.Subtract(theirs));
+  std::vector<uint32_t> inThis;
+  std::vector<uint32_t> inOther;
+  BOOST_CHECK(ours.Decode(inThis, inOther));
+  BOOST_CHECK(sorted(inThis) == onlyOurs);
+  BOOST_CHECK(sorted(inOther) == onlyTheirs);
+
+  BOOST_CHECK(!ours.Subtract(InvertibleBloomFilter(90)));
+}
+
+BOOST_AUTO_TEST_CASE(PeelTooLargeDifference)
+{
+  InvertibleBloomFilter ours(9);
+  for (uint32_t key = 0; key < 200; key++) {
+    ours.Insert(key);
+  }
+
+  // the keys that could be peeled are still right
+  std::vector<uint32_t> inThis;
+  std::vector<uint32_t> inOther;
+  BOOST_CHECK(!ours.Decode(inThis, inOther));
+  BOOST_CHECK(inOther.empty());
+  for (uint32_t key : inThis) {
+    BOOST_CHECK_LT(key, 200);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WireRoundTrip)
+{
+  InvertibleBloomFilter ibf(30);
+  for (uint32_t key = 0; key < 50; key++) {
+    ibf.Insert(key * 7919);
+  }
+  ibf.Erase(123456);
+
+  std::vector<uint8_t> wire(ibf.GetWireSize());
+  BOOST_CHECK_EQUAL(wire.size(), ibf.GetSize() * 12);
+  ibf.WireEncode(wire.data());
+
+  InvertibleBloomFilter decoded;
+  BOOST_CHECK(decoded.WireDecode(wire.data(), wire.size()));
+  BOOST_REQUIRE_EQUAL(decoded.GetSize(), ibf.GetSize());
+  for (uint32_t i = 0; i < ibf.GetSize(); i++) {
+    BOOST_CHECK_EQUAL(decoded.GetCell(i).count, ibf.GetCell(i).count);
+    BOOST_CHECK_EQUAL(decoded.GetCell(i).keySum, ibf.GetCell(i).keySum);
+    BOOST_CHECK_EQUAL(decoded.GetCell(i).hashSum, ibf.GetCell(i).hashSum);
+  }
+
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), 0));
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), wire.size() - 1));
+  // 10 cells are not a whole number of partitions
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), 10 * 12));
+}
+
+BOOST_AUTO_TEST_CASE(WireByteOrder)
+{
+  InvertibleBloomFilter ibf(3);
+  ibf.Erase(0x01020304);
+
+  std::vector<uint8_t> wire(ibf.GetWireSize());
+  ibf.WireEncode(wire.data());
+  size_t n = ibf.GetSize();
+  uint32_t i = ibf.GetCellIndex(0x01020304, 0);
+  // count -1, then the key, little-endian
+  BOOST_CHECK_EQUAL(wire[4 * i], 0xff);
+  BOOST_CHECK_EQUAL(wire[4 * i + 3], 0xff);
+  BOOST_CHECK_EQUAL(wire[4 * (n + i)], 0x04);
+  BOOST_CHECK_EQUAL(wire[4 * (n + i) + 3], 0x01);
+}
+
+BOOST_AUTO_TEST_CASE(WireEncodeCell)
+{
+  InvertibleBloomFilter ibf(30);
+  std::vector<uint8_t> patched(ibf.GetWireSize());
+  ibf.WireEncode(patched.data());
+
+  // patching the cells of a new key gives the encoding of the whole filter
+  ibf.Insert(42);
+  for (uint32_t h = 0; h < InvertibleBloomFilter::N_HASHES; h++) {
+    ibf.WireEncodeCell(ibf.GetCellIndex(42, h), patched.data());
+  }
+  std::vector<uint8_t> full(ibf.GetWireSize());
+  ibf.WireEncode(full.data());
+  BOOST_CHECK(patched == full);
+}
+
+BOOST_AUTO_TEST_CASE(StrataEstimate)
+{
+  StrataEstimator ours(10000);
+  StrataEstimator theirs(10000);
+  for (uint32_t key = 0; key < 10000; key++) {
+    ours.Insert(key);
+    if (key >= 200)
+      theirs.Insert(key);
+  }
+  BOOST_CHECK_EQUAL(ours.EstimateDifference(ours), 0);
+
+  // only an estimate of the 200 keys
+  uint32_t estimate = ours.EstimateDifference(theirs);
+  BOOST_CHECK_GE(estimate, 50);
+  BOOST_CHECK_LE(estimate, 800);
+
+  BOOST_CHECK_EQUAL(ours.EstimateDifference(StrataEstimator(10)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(StrataWireRoundTrip)
+{
+  StrataEstimator ours(1000);
+  for (uint32_t key = 0; key < 1000; key++) {
+    ours.Insert(key);
+  }
+  std::vector<uint8_t> wire;
+  ours.WireEncode(wire);
+  BOOST_CHECK_EQUAL(wire.size(), ours.GetWireSize());
+
+  StrataEstimator decoded(1000);
+  BOOST_CHECK(decoded.WireDecode(wire.data(), wire.size()));
+  BOOST_CHECK_EQUAL(decoded.EstimateDifference(ours), 0);
+  BOOST_CHECK(!decoded.WireDecode(wire.data(), wire.size() - 12));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
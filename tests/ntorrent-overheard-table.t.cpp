@@ -0,0 +1,105 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-overheard-table.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestOverheardTable)
+
+BOOST_AUTO_TEST_CASE(InsertRefresh)
+{
+  OverheardTable table(MilliSeconds(100));
+  BOOST_CHECK(!table.Refresh("/movie1/0", MilliSeconds(0)));
+
+  table.Insert("/movie1/0", MilliSeconds(10));
+  BOOST_CHECK(table.Refresh("/movie1/0", MilliSeconds(60)));
+  BOOST_CHECK(!table.Refresh("/movie1/1", MilliSeconds(60)));
+  BOOST_CHECK_EQUAL(table.GetSize(), 1);
+
+  // the refresh at 60ms extended the entry past its first expiry at 110ms
+  BOOST_CHECK(table.Refresh("/movie1/0", MilliSeconds(150)));
+}
+
+BOOST_AUTO_TEST_CASE(ExpiryOnRefresh)
+{
+  OverheardTable table(MilliSeconds(100));
+  table.Insert("/movie1/0", MilliSeconds(0));
+  table.Insert("/movie1/1", MilliSeconds(50));
+
+  // after the rotation at 100ms, both entries are in the previous generation
+  BOOST_CHECK(table.Refresh("/movie1/1", MilliSeconds(120)));
+
+  // the first one expired at 100ms and is removed on lookup
+  BOOST_CHECK_EQUAL(table.GetSize(), 2);
+  BOOST_CHECK(!table.Refresh("/movie1/0", MilliSeconds(120)));
+  BOOST_CHECK_EQUAL(table.GetSize(), 1);
+
+  // expiry is exclusive of the expiration time
+  table.Insert("/movie1/2", MilliSeconds(130));
+  BOOST_CHECK(!table.Refresh("/movie1/2", MilliSeconds(230)));
+}
+
+BOOST_AUTO_TEST_CASE(GenerationRotation)
+{
+  OverheardTable table(MilliSeconds(100));
+  table.Insert("/movie1/0", MilliSeconds(0));
+  table.Insert("/movie1/1", MilliSeconds(50));
+
+  // the rotation at 100ms moves both entries to the previous generation
+  table.Insert("/movie1/2", MilliSeconds(100));
+  BOOST_CHECK_EQUAL(table.GetSize(), 3);
+
+  // a refreshed entry moves back to the current generation and survives the
+  // next rotation, the one left in the previous generation is dropped
+  BOOST_CHECK(table.Refresh("/movie1/1", MilliSeconds(120)));
+  table.Insert("/movie1/3", MilliSeconds(200));
+  BOOST_CHECK_EQUAL(table.GetSize(), 3);
+  BOOST_CHECK(table.Refresh("/movie1/1", MilliSeconds(200)));
+  BOOST_CHECK(!table.Refresh("/movie1/0", MilliSeconds(200)));
+}
+
+BOOST_AUTO_TEST_CASE(LongSilence)
+{
+  OverheardTable table(MilliSeconds(100));
+  table.Insert("/movie1/0", MilliSeconds(0));
+  table.Insert("/movie1/1", MilliSeconds(90));
+
+  // nothing heard for a whole generation drops both generations at once
+  table.Insert("/movie1/2", MilliSeconds(300));
+  BOOST_CHECK_EQUAL(table.GetSize(), 1);
+  BOOST_CHECK(table.Refresh("/movie1/2", MilliSeconds(310)));
+  BOOST_CHECK(!table.Refresh("/movie1/1", MilliSeconds(310)));
+
+  // a shorter lifetime applies to the next insertions
+  table.SetLifetime(MilliSeconds(10));
+  BOOST_CHECK(table.GetLifetime() == MilliSeconds(10));
+  table.Insert("/movie1/3", MilliSeconds(320));
+  BOOST_CHECK(!table.Refresh("/movie1/3", MilliSeconds(330)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,121 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-availability.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestPieceAvailability)
+
+BOOST_AUTO_TEST_CASE(Decay)
+{
+  PieceAvailability availability(Seconds(10));
+  availability.Reset(4);
+  availability.Add(1, Seconds(0));
+  availability.Add(1, Seconds(0));
+  availability.Add(2, Seconds(10));
+  // pieces past the end are ignored
+  availability.Add(4, Seconds(0));
+
+  BOOST_CHECK_CLOSE(availability.GetScore(1, Seconds(0)), 2, 1e-9);
+  BOOST_CHECK_CLOSE(availability.GetScore(1, Seconds(10)), 1, 1e-9);
+  BOOST_CHECK_CLOSE(availability.GetScore(1, Seconds(20)), 0.5, 1e-9);
+  BOOST_CHECK_CLOSE(availability.GetScore(2, Seconds(20)), 0.5, 1e-9);
+  BOOST_CHECK_EQUAL(availability.GetScore(0, Seconds(20)), 0);
+  BOOST_CHECK_EQUAL(availability.GetScore(4, Seconds(20)), 0);
+
+  availability.Reset(4);
+  BOOST_CHECK_EQUAL(availability.GetScore(1, Seconds(20)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(NoDecay)
+{
+  PieceAvailability availability;
+  availability.SetHalfLife(Time());
+  availability.Reset(2);
+  availability.Add(0, Seconds(0));
+  availability.Add(0, Seconds(1000));
+  BOOST_CHECK_EQUAL(availability.GetScore(0, Seconds(5000)), 2);
+}
+
+BOOST_AUTO_TEST_CASE(FindRarest)
+{
+  PieceAvailability availability(Seconds(10));
+  availability.Reset(8);
+  PieceBitmap have(8);
+  PieceBitmap mine(8);
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), PieceBitmap::NO_PIECE);
+
+  have.Set(2);
+  have.Set(5);
+  have.Set(6);
+  // lowest sequence number on ties
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), 2);
+
+  availability.Add(2, Seconds(0));
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), 5);
+
+  // two old observations weigh less than a recent one
+  availability.Add(5, Seconds(0));
+  availability.Add(5, Seconds(0));
+  availability.Add(6, Seconds(20));
+  availability.Add(2, Seconds(20));
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), 5);
+
+  mine.Set(5);
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), 6);
+  mine.Set(2);
+  mine.Set(6);
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, mine), PieceBitmap::NO_PIECE);
+}
+
+// scores keep their order and value across the rescaling of the epoch
+BOOST_AUTO_TEST_CASE(Rescale)
+{
+  PieceAvailability availability(Seconds(1));
+  availability.Reset(3);
+  availability.Add(0, Seconds(0));
+  availability.Add(1, Seconds(250));
+  availability.Add(1, Seconds(250));
+
+  // far past 256 half-lives from the epoch
+  availability.Add(2, Seconds(1000));
+  availability.Add(2, Seconds(1000));
+  availability.Add(2, Seconds(1000));
+  BOOST_CHECK_CLOSE(availability.GetScore(2, Seconds(1001)), 1.5, 1e-9);
+  BOOST_CHECK_CLOSE(availability.GetScore(1, Seconds(1000)), 2 * std::exp2(-750), 1e-6);
+
+  PieceBitmap have(3);
+  have.SetAll();
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, PieceBitmap(3)), 0);
+  availability.Add(0, Seconds(2000));
+  BOOST_CHECK_EQUAL(availability.FindRarest(have, PieceBitmap(3)), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
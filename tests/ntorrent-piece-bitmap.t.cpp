@@ -0,0 +1,247 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-bitmap.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestPieceBitmap)
+
+// sizes around the 64-bit words, the 4-word AVX2 blocks and the bytes of the
+// wire encoding
+static const uint32_t SIZES[] = {0, 1, 7, 8, 9, 63, 64, 65, 127, 128, 129,
+                                 255, 256, 257, 511, 512, 513, 1000};
+
+static PieceBitmap
+makeRandomBitmap(uint32_t size, double density, std::mt19937& random)
+{
+  std::bernoulli_distribution isSet(density);
+  PieceBitmap bitmap(size);
+  for (uint32_t seq = 0; seq < size; seq++) {
+    if (isSet(random))
+      bitmap.Set(seq);
+  }
+  return bitmap;
+}
+
+BOOST_AUTO_TEST_CASE(SetResetTest)
+{
+  PieceBitmap bitmap(130);
+  bitmap.Set(0);
+  bitmap.Set(64);
+  bitmap.Set(129);
+  // pieces past the end are ignored
+  bitmap.Set(130);
+  BOOST_CHECK(bitmap.Test(0));
+  BOOST_CHECK(bitmap.Test(64));
+  BOOST_CHECK(bitmap.Test(129));
+  BOOST_CHECK(!bitmap.Test(1));
+  BOOST_CHECK(!bitmap.Test(130));
+  BOOST_CHECK_EQUAL(bitmap.Count(), 3);
+
+  bitmap.Reset(64);
+  BOOST_CHECK(!bitmap.Test(64));
+  BOOST_CHECK_EQUAL(bitmap.Count(), 2);
+
+  bitmap.SetAll();
+  BOOST_CHECK_EQUAL(bitmap.Count(), 130);
+}
+
+// CountMissing and FindFirstMissing go through AVX2 when built with --native:
+// check them against the bit by bit definition
+BOOST_AUTO_TEST_CASE(WordOperationsMatchBits)
+{
+  std::mt19937 random(1);
+  for (uint32_t size : SIZES) {
+    for (double density : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+      PieceBitmap have = makeRandomBitmap(size, density, random);
+      PieceBitmap mine = makeRandomBitmap(size, 0.5, random);
+
+      uint32_t count = 0;
+      std::vector<uint32_t> missing;
+      std::vector<uint32_t> missingInBoth;
+      for (uint32_t seq = 0; seq < size; seq++) {
+        if (have.Test(seq) && !mine.Test(seq)) {
+          count++;
+          missing.push_back(seq);
+        }
+        if (!have.Test(seq) && !mine.Test(seq))
+          missingInBoth.push_back(seq);
+      }
+      BOOST_CHECK_EQUAL(have.CountMissing(mine), count);
+
+      for (uint32_t from = 0; from <= size; from++) {
+        auto first = std::lower_bound(missing.begin(), missing.end(), from);
+        uint32_t expected = (first == missing.end()) ? PieceBitmap::NO_PIECE : *first;
+        BOOST_CHECK_EQUAL(have.FindFirstMissing(mine, from), expected);
+      }
+
+      std::vector<uint32_t> set;
+      for (uint32_t seq = 0; seq < size; seq++) {
+        if (have.Test(seq))
+          set.push_back(seq);
+      }
+      std::vector<uint32_t> listed;
+      have.ForEachSet([&listed] (uint32_t seq) { listed.push_back(seq); });
+      BOOST_CHECK(listed == set);
+
+      listed.clear();
+      have.ForEachMissing(mine, [&listed] (uint32_t seq) { listed.push_back(seq); });
+      BOOST_CHECK(listed == missing);
+
+      listed.clear();
+      have.ForEachMissingInBoth(mine, [&listed] (uint32_t seq) { listed.push_back(seq); });
+      BOOST_CHECK(listed == missingInBoth);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WireRoundTrip)
+{
+  std::mt19937 random(2);
+  for (uint32_t size : SIZES) {
+    PieceBitmap bitmap = makeRandomBitmap(size, 0.5, random);
+    std::vector<uint8_t> wire(bitmap.GetWireSize());
+    BOOST_CHECK_EQUAL(wire.size(), (size + 7) / 8);
+    bitmap.WireEncode(wire.data());
+
+    // piece i is bit i % 8 of byte i / 8
+    for (uint32_t seq = 0; seq < size; seq++) {
+      BOOST_CHECK_EQUAL(((wire[seq / 8] >> (seq % 8)) & 1) != 0, bitmap.Test(seq));
+    }
+
+    PieceBitmap decoded(size);
+    BOOST_CHECK(decoded.WireDecode(wire.data(), wire.size()));
+    BOOST_CHECK(decoded == bitmap);
+
+    BOOST_CHECK(!decoded.WireDecode(wire.data(), wire.size() + 1));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WireDecodeClearsTail)
+{
+  const uint8_t wire[] = {0xff, 0xff};
+  PieceBitmap bitmap(9);
+  BOOST_CHECK(bitmap.WireDecode(wire, sizeof(wire)));
+  BOOST_CHECK_EQUAL(bitmap.Count(), 9);
+  BOOST_CHECK_EQUAL(bitmap.CountMissing(PieceBitmap(9)), 9);
+}
+
+static void
+checkCompactRoundTrip(const PieceBitmap& bitmap, int expectedFormat = -1)
+{
+  std::vector<uint8_t> wire;
+  bitmap.EncodeCompact(wire);
+  BOOST_REQUIRE(!wire.empty());
+  BOOST_CHECK_EQUAL(wire[0] >> 4, PieceBitmap::COMPACT_VERSION);
+  if (expectedFormat >= 0)
+    BOOST_CHECK_EQUAL(wire[0] & 0x0f, expectedFormat);
+
+  // a header byte and a 5-byte size at most on top of the raw encoding
+  BOOST_CHECK_LE(wire.size(), 1 + 5 + bitmap.GetWireSize());
+
+  PieceBitmap decoded(bitmap.GetSize());
+  BOOST_CHECK(decoded.DecodeCompact(wire.data(), wire.size()));
+  BOOST_CHECK(decoded == bitmap);
+}
+
+BOOST_AUTO_TEST_CASE(CompactRoundTrip)
+{
+  std::mt19937 random(3);
+  for (uint32_t size : SIZES) {
+    for (double density : {0.0, 0.001, 0.05, 0.5, 0.95, 0.999, 1.0}) {
+      checkCompactRoundTrip(makeRandomBitmap(size, density, random));
+    }
+
+    // runs ending on word boundaries
+    PieceBitmap runs(size);
+    for (uint32_t seq = 0; seq < size; seq++) {
+      if ((seq / 64) % 2 == 1)
+        runs.Set(seq);
+    }
+    checkCompactRoundTrip(runs);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CompactFormats)
+{
+  std::mt19937 random(4);
+  checkCompactRoundTrip(makeRandomBitmap(1000, 0.5, random), PieceBitmap::COMPACT_RAW);
+
+  PieceBitmap halves(1000);
+  for (uint32_t seq = 500; seq < 1000; seq++) {
+    halves.Set(seq);
+  }
+  checkCompactRoundTrip(halves, PieceBitmap::COMPACT_RUNS);
+
+  PieceBitmap sparse(1000);
+  sparse.Set(3);
+  sparse.Set(400);
+  sparse.Set(999);
+  checkCompactRoundTrip(sparse, PieceBitmap::COMPACT_PRESENT);
+
+  PieceBitmap dense(1000);
+  dense.SetAll();
+  dense.Reset(0);
+  dense.Reset(500);
+  dense.Reset(998);
+  checkCompactRoundTrip(dense, PieceBitmap::COMPACT_MISSING);
+}
+
+BOOST_AUTO_TEST_CASE(CompactMalformed)
+{
+  PieceBitmap bitmap(100);
+  std::vector<uint8_t> wire;
+  bitmap.EncodeCompact(wire);
+
+  // wrong size
+  PieceBitmap other(101);
+  BOOST_CHECK(!other.DecodeCompact(wire.data(), wire.size()));
+
+  // unknown version
+  std::vector<uint8_t> badVersion(wire);
+  badVersion[0] = static_cast<uint8_t>((PieceBitmap::COMPACT_VERSION + 1) << 4 | (wire[0] & 0x0f));
+  BOOST_CHECK(!bitmap.DecodeCompact(badVersion.data(), badVersion.size()));
+
+  BOOST_CHECK(!bitmap.DecodeCompact(wire.data(), 0));
+
+  // a present piece past the end
+  const uint8_t pastEnd[] = {PieceBitmap::COMPACT_VERSION << 4 | PieceBitmap::COMPACT_PRESENT, 100, 100};
+  BOOST_CHECK(!bitmap.DecodeCompact(pastEnd, sizeof(pastEnd)));
+
+  // runs longer than the bitmap
+  const uint8_t longRuns[] = {PieceBitmap::COMPACT_VERSION << 4 | PieceBitmap::COMPACT_RUNS, 100, 60, 50};
+  BOOST_CHECK(!bitmap.DecodeCompact(longRuns, sizeof(longRuns)));
+
+  // truncated varint
+  const uint8_t truncated[] = {PieceBitmap::COMPACT_VERSION << 4 | PieceBitmap::COMPACT_MISSING, 100, 0x80};
+  BOOST_CHECK(!bitmap.DecodeCompact(truncated, sizeof(truncated)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
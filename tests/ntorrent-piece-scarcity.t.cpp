@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-piece-scarcity.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestPieceScarcity)
+
+BOOST_AUTO_TEST_CASE(Counters)
+{
+  PieceScarcity scarcity;
+  scarcity.Reset(10);
+  BOOST_CHECK(scarcity.IsEmpty());
+
+  for (uint32_t seq = 0; seq < 10; seq++) {
+    scarcity.Insert(seq);
+  }
+  scarcity.Increment(3);
+  scarcity.Increment(3);
+  scarcity.Increment(7);
+  BOOST_CHECK_EQUAL(scarcity.GetSize(), 10);
+  BOOST_CHECK_EQUAL(scarcity.GetCount(3), 3);
+  BOOST_CHECK_EQUAL(scarcity.GetCount(7), 2);
+  BOOST_CHECK_EQUAL(scarcity.GetCount(0), 1);
+
+  // the highest counter first
+  BOOST_CHECK_EQUAL(scarcity.FindRarest([] (uint32_t) { return true; }), 3);
+  BOOST_CHECK_EQUAL(scarcity.FindRarest([] (uint32_t seq) { return seq != 3; }), 7);
+  BOOST_CHECK_EQUAL(scarcity.FindRarest([] (uint32_t) { return false; }), PieceScarcity::NO_PIECE);
+
+  scarcity.Erase(3);
+  BOOST_CHECK(!scarcity.Contains(3));
+  BOOST_CHECK_EQUAL(scarcity.GetCount(3), 0);
+  BOOST_CHECK_EQUAL(scarcity.GetSize(), 9);
+
+  // untracked pieces are ignored
+  scarcity.Increment(3);
+  scarcity.Erase(3);
+  BOOST_CHECK_EQUAL(scarcity.GetSize(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(FindRarestFrom)
+{
+  PieceScarcity scarcity;
+  scarcity.Reset(100);
+  for (uint32_t seq = 0; seq < 100; seq++) {
+    scarcity.Insert(seq);
+  }
+
+  PieceBitmap bitmap(100);
+  bitmap.Set(10);
+  bitmap.Set(20);
+  bitmap.Set(30);
+  scarcity.UpdateNeighbor(1, bitmap);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), 10);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(2), PieceScarcity::NO_PIECE);
+
+  scarcity.Increment(30);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), 30);
+
+  scarcity.SetPending(30, true);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), 10);
+  scarcity.Erase(10);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), 20);
+  scarcity.SetPending(30, false);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), 30);
+
+  scarcity.EraseNeighbor(1);
+  BOOST_CHECK_EQUAL(scarcity.FindRarestFrom(1), PieceScarcity::NO_PIECE);
+}
+
+// the neighbor trees against a scan of all the pieces, under random updates
+BOOST_AUTO_TEST_CASE(FindRarestFromMatchesScan)
+{
+  std::mt19937 random(5);
+  for (uint32_t size : {1, 2, 63, 64, 65, 300}) {
+    PieceScarcity scarcity;
+    scarcity.Reset(size);
+    std::vector<PieceBitmap> bitmaps(3, PieceBitmap(size));
+    for (uint32_t seq = 0; seq < size; seq++) {
+      if (random() % 4 != 0)
+        scarcity.Insert(seq);
+      for (PieceBitmap& bitmap : bitmaps) {
+        if (random() % 2 == 0)
+          bitmap.Set(seq);
+      }
+    }
+    for (uint32_t nodeId = 0; nodeId < bitmaps.size(); nodeId++) {
+      scarcity.UpdateNeighbor(nodeId, bitmaps[nodeId]);
+    }
+
+    for (int i = 0; i < 2000; i++) {
+      uint32_t seq = random() % size;
+      switch (random() % 7) {
+      case 0:
+        scarcity.Erase(seq);
+        break;
+      case 1:
+        scarcity.Insert(seq);
+        break;
+      case 2:
+        scarcity.SetPending(seq, random() % 2 == 0);
+        break;
+      case 3: {
+        // small batches are applied piece by piece, large ones rebuild the trees
+        std::vector<uint32_t> seqs(random() % 2 == 0 ? 1 : size);
+        for (uint32_t& s : seqs)
+          s = random() % size;
+        scarcity.IncrementAll(seqs);
+        break;
+      }
+      default:
+        scarcity.Increment(seq);
+        break;
+      }
+
+      uint32_t nodeId = random() % bitmaps.size();
+      if (random() % 20 == 0) {
+        bitmaps[nodeId].Set(random() % size);
+        scarcity.UpdateNeighbor(nodeId, bitmaps[nodeId]);
+      }
+
+      uint32_t expected = PieceScarcity::NO_PIECE;
+      uint32_t highest = 0;
+      for (uint32_t s = 0; s < size; s++) {
+        if (bitmaps[nodeId].Test(s) && !scarcity.IsPending(s) && scarcity.GetCount(s) > highest) {
+          highest = scarcity.GetCount(s);
+          expected = s;
+        }
+      }
+      BOOST_REQUIRE_EQUAL(scarcity.FindRarestFrom(nodeId), expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,86 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-relay-cache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestRelayCache)
+
+static std::shared_ptr<const ::ndn::Data>
+makeData(const ::ndn::Name& name)
+{
+  auto data = std::make_shared<::ndn::Data>(name);
+  ::ndn::Signature signature(::ndn::SignatureInfo(::ndn::tlv::DigestSha256));
+  signature.setValue(::ndn::makeNonNegativeIntegerBlock(::ndn::tlv::SignatureValue, 0));
+  data->setSignature(signature);
+  return data;
+}
+
+BOOST_AUTO_TEST_CASE(LeastFrequentlyUsed)
+{
+  RelayCache cache(2);
+  cache.Insert(makeData("/movie1/%00%01"));
+  cache.Insert(makeData("/movie1/%00%02"));
+  BOOST_CHECK(cache.Find("/movie1/%00%01") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%01") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%02") != nullptr);
+
+  cache.Insert(makeData("/movie1/%00%03"));
+  BOOST_CHECK_EQUAL(cache.GetSize(), 2);
+  BOOST_CHECK(cache.Find("/movie1/%00%01") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%02") == nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%03") != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(NewPieceAfterHits)
+{
+  RelayCache cache(3);
+  cache.Insert(makeData("/movie1/%00%01"));
+  cache.Insert(makeData("/movie1/%00%02"));
+  cache.Insert(makeData("/movie1/%00%03"));
+  BOOST_CHECK(cache.Find("/movie1/%00%01") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%02") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%03") != nullptr);
+
+  // the new piece is admitted at the lowest key, so the least recently used
+  // piece is evicted rather than the new one
+  cache.Insert(makeData("/movie1/%00%04"));
+  BOOST_CHECK_EQUAL(cache.GetSize(), 3);
+  BOOST_CHECK(cache.Find("/movie1/%00%04") != nullptr);
+  BOOST_CHECK(cache.Find("/movie1/%00%01") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  RelayCache cache(0);
+  cache.Insert(makeData("/movie1/%00%01"));
+  BOOST_CHECK_EQUAL(cache.GetSize(), 0);
+  BOOST_CHECK(cache.Find("/movie1/%00%01") == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3
@@ -0,0 +1,69 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 University of California, Los Angeles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Spyridon (Spyros) Mastorakis <mastorakis@cs.ucla.edu>
+ *          Alexander Afanasyev <alexander.afanasyev@ucla.edu>
+ */
+
+#include "ntorrent-varint.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace ns3 {
+namespace ndn {
+
+BOOST_AUTO_TEST_SUITE(TestVarint)
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+  const uint32_t values[] = {0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 0x1fffff, 0x200000,
+                             0xfffffff, 0x10000000, 0xffffffff};
+  for (uint32_t value : values) {
+    std::vector<uint8_t> wire;
+    appendVarint(wire, value);
+    BOOST_CHECK_EQUAL(wire.size(), varintSize(value));
+
+    const uint8_t* it = wire.data();
+    uint32_t decoded = 0;
+    BOOST_CHECK(readVarint(it, wire.data() + wire.size(), decoded));
+    BOOST_CHECK_EQUAL(decoded, value);
+    BOOST_CHECK(it == wire.data() + wire.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Malformed)
+{
+  uint32_t value;
+
+  // the last byte still has its continuation bit set
+  const uint8_t truncated[] = {0x80, 0x80};
+  const uint8_t* it = truncated;
+  BOOST_CHECK(!readVarint(it, truncated + sizeof(truncated), value));
+
+  // a fifth byte holding more than the 4 upper bits of 32-bit values
+  const uint8_t overlong[] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+  it = overlong;
+  BOOST_CHECK(!readVarint(it, overlong + sizeof(overlong), value));
+
+  it = overlong;
+  BOOST_CHECK(!readVarint(it, overlong, value));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn
+} // namespace ns3